@@ -0,0 +1,126 @@
+//
+//  MidiDecodeBenchmark.cpp
+//
+//  Messages/second through the input decode path: the old at() based switch,
+//  midi::decode() on its own, and the whole Input::processMessage() with polling.
+//
+//  See licence and credits in MidiIn.h.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "MidiIn.h"
+
+using namespace cinder::midi;
+
+namespace {
+
+	const size_t kIterations = 4000000;
+
+	/// A mixed stream of the usual channel traffic, short messages included.
+	std::vector<std::vector<unsigned char>> makeMessages(){
+		std::vector<std::vector<unsigned char>> messages;
+		for( unsigned char i = 0; i < 16; ++i ){
+			messages.push_back( { (unsigned char) ( MIDI_NOTE_ON | i ), (unsigned char) ( 60 + i ), 100 } );
+			messages.push_back( { (unsigned char) ( MIDI_NOTE_OFF | i ), (unsigned char) ( 60 + i ), 0 } );
+			messages.push_back( { (unsigned char) ( MIDI_CONTROL_CHANGE | i ), 7, (unsigned char) ( i * 8 ) } );
+			messages.push_back( { (unsigned char) ( MIDI_PITCH_BEND | i ), 0, 64 } );
+			messages.push_back( { (unsigned char) ( MIDI_PROGRAM_CHANGE | i ), i } );
+			messages.push_back( { (unsigned char) ( MIDI_AFTERTOUCH | i ), 90 } );
+		}
+		messages.push_back( { MIDI_TIME_CLOCK } );
+		return messages;
+	}
+
+	/// The decoder processMessage() used before midi::decode(), kept here as the baseline.
+	Message decodeWithAt( const std::vector<unsigned char> &message, int port ){
+		Message msg;
+		msg.port = port;
+		if( message.at( 0 ) >= MIDI_SYSEX ){
+			msg.status = message.at( 0 ) & 0xFF;
+			msg.channel = 0;
+		}
+		else {
+			msg.status = message.at( 0 ) & 0xF0;
+			msg.channel = ( message.at( 0 ) & 0x0F ) + 1;
+		}
+
+		switch( msg.status ){
+		case MIDI_NOTE_ON:
+		case MIDI_NOTE_OFF:
+			msg.pitch = message.at( 1 );
+			msg.velocity = message.at( 2 );
+			break;
+		case MIDI_CONTROL_CHANGE:
+			msg.control = message.at( 1 );
+			msg.value = message.at( 2 );
+			break;
+		case MIDI_PROGRAM_CHANGE:
+		case MIDI_AFTERTOUCH:
+			msg.value = message.at( 1 );
+			break;
+		case MIDI_PITCH_BEND:
+			msg.value = ( message.at( 2 ) << 7 ) + message.at( 1 );
+			break;
+		case MIDI_POLY_AFTERTOUCH:
+			msg.pitch = message.at( 1 );
+			msg.value = message.at( 2 );
+			break;
+		default:
+			break;
+		}
+		return msg;
+	}
+
+	template<typename Fn>
+	void report( const char *name, Fn &&fn ){
+		const auto start = std::chrono::steady_clock::now();
+		const int checksum = fn();
+		const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+		std::printf( "%-28s %8.1f M messages/s  (checksum %d)\n", name, kIterations / seconds / 1e6, checksum );
+	}
+
+}
+
+int main(){
+	std::vector<std::vector<unsigned char>> messages = makeMessages();
+	const size_t count = messages.size();
+
+	report( "at() switch (before)", [&](){
+		int checksum = 0;
+		for( size_t i = 0; i < kIterations; ++i )
+			checksum += decodeWithAt( messages[i % count], 0 ).value;
+		return checksum;
+	});
+
+	report( "midi::decode()", [&](){
+		int checksum = 0;
+		for( size_t i = 0; i < kIterations; ++i ){
+			const std::vector<unsigned char> &message = messages[i % count];
+			checksum += decode( message.data(), message.size() ).data1;
+		}
+		return checksum;
+	});
+
+	// there is no app to dispatch to, events are only polled
+	Input input;
+	input.setDispatchToMainThread( false );
+	input.setPollingEnabled( true, 1024 );
+	report( "Input::processMessage()", [&](){
+		int checksum = 0;
+		Event events[256];
+		for( size_t i = 0; i < kIterations; ++i ){
+			input.processMessage( 0.0, &messages[i % count], 0 );
+			if( ( i & 255 ) == 255 ){
+				const size_t polled = input.poll( events, 256 );
+				for( size_t e = 0; e < polled; ++e )
+					checksum += events[e].data1;
+			}
+		}
+		return checksum;
+	});
+
+	return 0;
+}
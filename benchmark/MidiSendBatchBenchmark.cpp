@@ -0,0 +1,72 @@
+//
+//  MidiSendBatchBenchmark.cpp
+//
+//  Events/second into a virtual output port, sending 64 note chords and
+//  128 controller resets one sendMessage() at a time versus one sendBatch().
+//
+//  See licence and credits in MidiOut.h.
+//
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "MidiOut.h"
+
+using namespace cinder::midi;
+
+namespace {
+
+	const size_t kEvents = 1 << 20;
+
+	std::vector<Event> makeChord( size_t size ){
+		std::vector<Event> events;
+		for( size_t i = 0; i < size; ++i )
+			events.push_back( Event( MIDI_NOTE_ON, (uint8_t) ( 32 + i % 64 ), 100 ) );
+		return events;
+	}
+
+	std::vector<Event> makeControllerReset( size_t size ){
+		std::vector<Event> events;
+		for( size_t i = 0; i < size; ++i )
+			events.push_back( Event( (uint8_t) ( MIDI_CONTROL_CHANGE | ( i / 8 % 16 ) ), (uint8_t) ( i % 120 ), 0 ) );
+		return events;
+	}
+
+	template<typename Fn>
+	double measure( const std::vector<Event> &burst, Fn &&send ){
+		const size_t bursts = kEvents / burst.size();
+		const auto start = std::chrono::steady_clock::now();
+		for( size_t i = 0; i < bursts; ++i )
+			send( burst );
+		const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+		return bursts * burst.size() / seconds;
+	}
+
+	void compare( MidiOut &out, const char *name, const std::vector<Event> &burst ){
+		const double single = measure( burst, [&]( const std::vector<Event> &events ){
+			for( const Event &event : events )
+				out.sendMessage( event );
+		});
+		const double batched = measure( burst, [&]( const std::vector<Event> &events ){
+			out.sendBatch( events );
+		});
+		std::printf( "%-22s sendMessage %8.0f k events/s   sendBatch %8.0f k events/s   x%.1f\n",
+			name, single / 1e3, batched / 1e3, batched / single );
+	}
+
+}
+
+int main(){
+	MidiOut out;
+	if( ! out.openVirtualPort( "MidiSendBatchBenchmark" ) ){
+		std::printf( "could not open a virtual output port\n" );
+		return 1;
+	}
+
+	compare( out, "64 note chord", makeChord( 64 ) );
+	compare( out, "128 controller reset", makeControllerReset( 128 ) );
+
+	out.closePort();
+	return 0;
+}
@@ -0,0 +1,125 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "MidiEvent.h"
+
+
+namespace cinder { namespace midi {
+
+	///
+	/// Which notes are held on each of the 16 channels, as a 16 x 128 bit map.
+	///
+	/// update() runs on the thread that sees the events; a note on with velocity 0 counts
+	/// as a note off. Queries and releases work from any thread: bits are cleared with
+	/// atomic exchanges, so a note released here is never released twice, even while the
+	/// midi thread keeps updating.
+	///
+	class ActiveNotes {
+	public:
+		ActiveNotes();
+
+		/// \return true if \a event started or ended a note
+		bool update( const Event &event );
+		void reset();
+
+		/// Channels are 1 - 16.
+		bool isHeld( int channel, int note ) const;
+		/// Number of held notes on \a channel, or on all channels when \a channel is 0.
+		int getHeldCount( int channel = 0 ) const;
+		/// Event::time of the note on that started a held note.
+		uint32_t getOnTime( int channel, int note ) const { return mOnTime[channel - 1][note & 0x7F].load( std::memory_order_relaxed ); }
+
+		/// Calls \a fn( note ) for every held note on \a channel, lowest first.
+		template<typename Fn>
+		void forEachHeld( int channel, Fn &&fn ) const
+		{
+			for( int word = 0; word < 2; ++word ){
+				uint64_t bits = mBits[channel - 1][word].load( std::memory_order_acquire );
+				while( bits ){
+					fn( word * 64 + countTrailingZeros( bits ) );
+					bits &= bits - 1;
+				}
+			}
+		}
+
+		/// Clears every held note and calls \a fn( const Event& ) with a matching note off.
+		/// \return the number of notes released
+		template<typename Fn>
+		int releaseAll( Fn &&fn, uint32_t time = 0 )
+		{
+			return release( fn, time, 0, false );
+		}
+
+		/// Same as releaseAll() for notes held longer than \a maxHeldMicros at \a now,
+		/// both in Event::time units. Holds longer than the 71 minute wrap of the 32 bit
+		/// time base can't be told apart from fresh ones.
+		template<typename Fn>
+		int releaseOlderThan( uint32_t now, uint32_t maxHeldMicros, Fn &&fn )
+		{
+			return release( fn, now, maxHeldMicros, true );
+		}
+
+		static int popCount( uint64_t bits );
+		static int countTrailingZeros( uint64_t bits );
+
+	private:
+		template<typename Fn>
+		int release( Fn &fn, uint32_t now, uint32_t maxHeldMicros, bool onlyOlder )
+		{
+			int released = 0;
+			for( int ch = 0; ch < 16; ++ch ){
+				for( int word = 0; word < 2; ++word ){
+					uint64_t bits = mBits[ch][word].load( std::memory_order_acquire );
+					while( bits ){
+						const int note = word * 64 + countTrailingZeros( bits );
+						bits &= bits - 1;
+						if( onlyOlder && uint32_t( now - mOnTime[ch][note].load( std::memory_order_relaxed ) ) <= maxHeldMicros )
+							continue;
+						// only the caller that actually clears the bit sends the note off
+						const uint64_t mask = uint64_t( 1 ) << ( note & 63 );
+						if( !( mBits[ch][word].fetch_and( ~mask, std::memory_order_acq_rel ) & mask ) )
+							continue;
+						fn( Event( uint8_t( MIDI_NOTE_OFF | ch ), uint8_t( note ), 0, mPort.load( std::memory_order_relaxed ), now ) );
+						++released;
+					}
+				}
+			}
+			return released;
+		}
+
+		std::atomic<uint64_t>	mBits[16][2];
+		std::atomic<uint32_t>	mOnTime[16][128];
+		std::atomic<uint8_t>	mPort;
+	};
+
+} // namespace midi
+} // namespace cinder
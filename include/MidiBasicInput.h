@@ -0,0 +1,160 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "RtMidi.h"
+#include "MidiConstants.h"
+#include "MidiExceptions.h"
+#include "MidiDecoder.h"
+
+
+namespace cinder { namespace midi {
+
+	///
+	/// No-op handlers to derive from. BasicInput calls the derived class' methods
+	/// directly, so only hide the ones you need; nothing here is virtual.
+	///
+	struct BasicInputHandler {
+		void onNoteOn( const Event & ) {}
+		/// Also receives note ons with velocity 0.
+		void onNoteOff( const Event & ) {}
+		void onPolyAftertouch( const Event & ) {}
+		void onControlChange( const Event & ) {}
+		void onProgramChange( const Event & ) {}
+		void onAftertouch( const Event & ) {}
+		void onPitchBend( const Event & ) {}
+		/// \a data holds the whole message from MIDI_SYSEX to MIDI_SYSEX_END, valid for the call only.
+		void onSysex( const uint8_t *, size_t, const Event & ) {}
+		/// Timing, transport and other system messages.
+		void onSystem( const Event & ) {}
+	};
+
+	///
+	/// A midi input without signals, queues or virtual calls in the way.
+	///
+	/// Messages are decoded in the RtMidi callback and handed straight to \a Handler,
+	/// so the compiler can inline the whole path into your code. Everything runs on
+	/// the midi thread. Use Input for main thread delivery, polling and the trackers.
+	///
+	///   struct Synth : midi::BasicInputHandler {
+	///       void onNoteOn( const midi::Event &e ) { ... }
+	///   };
+	///   midi::BasicInput<Synth> input;
+	///   input.openPort( 0 );
+	///
+	template<typename Handler>
+	class BasicInput {
+	public:
+		BasicInput() : BasicInput( Handler() ) {}
+		explicit BasicInput( const Handler &handler )
+			: mHandler( handler ), mMidiIn( new RtMidiIn() ), mPort( 0 ), mOpen( false ), mEpoch( std::chrono::steady_clock::now() )
+		{
+		}
+		~BasicInput() { closePort(); }
+
+		BasicInput( const BasicInput& ) = delete;
+		BasicInput& operator=( const BasicInput& ) = delete;
+
+		unsigned int getNumPorts() const { return mMidiIn->getPortCount(); }
+		std::string getPortName( unsigned int port ) const { return mMidiIn->getPortName( port ).c_str(); } // strip null chars introduced by rtmidi
+		unsigned int getPort() const { return mPort; }
+
+		void openPort( unsigned int port = 0 )
+		{
+			if( getNumPorts() == 0 )
+				throw MidiExcNoPortsAvailable();
+			if( port >= getNumPorts() )
+				throw MidiExcPortNotAvailable();
+
+			mPort = port;
+			mEpoch = std::chrono::steady_clock::now();
+			mMidiIn->openPort( port );
+			mMidiIn->setCallback( &BasicInput::callback, this );
+			mMidiIn->ignoreTypes( false, false, false );
+			mOpen = true;
+		}
+
+		void closePort()
+		{
+			if( !mOpen )
+				return;
+			mMidiIn->closePort();
+			mMidiIn->cancelCallback();
+			mOpen = false;
+		}
+		bool isOpen() const { return mOpen; }
+
+		void ignoreTypes( bool sysex, bool time, bool midisense ) { mMidiIn->ignoreTypes( sysex, time, midisense ); }
+
+		Handler& getHandler() { return mHandler; }
+		const Handler& getHandler() const { return mHandler; }
+
+		/// Decodes \a data and calls the handler, as the port's callback does.
+		void process( const uint8_t *data, size_t size )
+		{
+			const uint32_t time = (uint32_t) std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - mEpoch ).count();
+			const Event event = decode( data, size, (uint8_t) mPort, time );
+			switch( event.getStatus() ){
+			case MIDI_NOTE_ON:
+				if( event.data2 > 0 )
+					mHandler.onNoteOn( event );
+				else
+					mHandler.onNoteOff( event );
+				break;
+			case MIDI_NOTE_OFF:			mHandler.onNoteOff( event ); break;
+			case MIDI_POLY_AFTERTOUCH:	mHandler.onPolyAftertouch( event ); break;
+			case MIDI_CONTROL_CHANGE:	mHandler.onControlChange( event ); break;
+			case MIDI_PROGRAM_CHANGE:	mHandler.onProgramChange( event ); break;
+			case MIDI_AFTERTOUCH:		mHandler.onAftertouch( event ); break;
+			case MIDI_PITCH_BEND:		mHandler.onPitchBend( event ); break;
+			case MIDI_SYSEX:			mHandler.onSysex( data, size, event ); break;
+			case MIDI_UNKNOWN:			break;
+			default:					mHandler.onSystem( event ); break;
+			}
+		}
+
+	private:
+		static void callback( double, std::vector<unsigned char> *message, void *userData )
+		{
+			static_cast<BasicInput*>( userData )->process( message->data(), message->size() );
+		}
+
+		Handler								mHandler;
+		std::unique_ptr<RtMidiIn>			mMidiIn;
+		unsigned int						mPort;
+		bool								mOpen;
+		std::chrono::steady_clock::time_point	mEpoch;
+	};
+
+} // namespace midi
+} // namespace cinder
@@ -0,0 +1,99 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "MidiEvent.h"
+
+
+namespace cinder { namespace midi {
+
+	/// Consistent copy of the clock follower, see ClockTracker::read().
+	struct ClockState {
+		static const int TICKS_PER_BEAT = 24;
+
+		bool		running;
+		uint32_t	ticks;			//< clock ticks since song start, set by start and song position pointer
+		uint32_t	tickTime;		//< smoothed Event::time of the last tick
+		double		secondsPerTick;	//< 0 until the tempo is known
+
+		double getBpm() const { return secondsPerTick > 0.0 ? 60.0 / ( secondsPerTick * TICKS_PER_BEAT ) : 0.0; }
+		/// Quarter notes since song start at \a now, in Event::time units. While running the
+		/// position is interpolated from the last tick, at most one tick ahead.
+		double getBeats( uint32_t now ) const;
+		/// Position within the current beat, 0 - 1.
+		double getBeatPhase( uint32_t now ) const;
+	};
+
+	///
+	/// Follows an incoming MIDI clock on the midi thread.
+	///
+	/// The tempo is a least squares fit over the last beat of clock ticks, which
+	/// averages out the scheduling jitter on the tick timestamps, and restarts after
+	/// a gap in the clock. Start, continue, stop and song position pointer move the
+	/// transport. The state is published through a sequence lock; read() is lock-free
+	/// and can be called from any thread.
+	///
+	class ClockTracker {
+	public:
+		ClockTracker();
+
+		/// Midi thread. \return true if \a event was a clock or transport message
+		bool process( const Event &event );
+		void reset();
+
+		/// Any thread.
+		void read( ClockState &state ) const;
+
+	private:
+		void onTick( uint32_t time );
+		void publish( uint32_t tickTime );
+
+		static const int WINDOW = ClockState::TICKS_PER_BEAT;
+
+		// midi thread only
+		uint32_t	mTickTimes[WINDOW];
+		int			mTickCount;			//< ticks in the window
+		int			mTickHead;			//< oldest tick in the window
+		double		mSecondsPerTick;
+		uint32_t	mLastTick;
+		uint32_t	mTicks;
+		bool		mRunning;
+		bool		mAwaitingFirstTick;	//< the first tick after start / continue doesn't advance
+
+		std::atomic<uint32_t>	mSequence;
+		std::atomic<bool>		mStateRunning;
+		std::atomic<uint32_t>	mStateTicks;
+		std::atomic<uint32_t>	mStateTickTime;
+		std::atomic<uint64_t>	mStateSecondsPerTick;	//< bit pattern of a double
+	};
+
+} // namespace midi
+} // namespace cinder
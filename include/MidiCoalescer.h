@@ -0,0 +1,80 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "MidiEvent.h"
+
+
+namespace cinder { namespace midi {
+
+	///
+	/// Last-value-wins slots for controller, pitch bend and channel pressure updates.
+	///
+	/// The midi thread store()s every such event; only the first update into a clean
+	/// slot needs to be queued, as a marker. When the consumer reaches the marker,
+	/// take() returns whatever value the slot holds by then. Every update that lands
+	/// on an already pending slot is elided. Other events never go through here, so
+	/// notes and sysex keep their exact order.
+	///
+	class Coalescer {
+	public:
+		Coalescer();
+
+		/// true for control change, pitch bend and channel pressure
+		static bool isCoalescable( const Event &event );
+
+		/// Producer side. \return true if \a event must be queued as the slot's marker,
+		/// false if it was folded into an update that is already pending.
+		bool store( const Event &event );
+		/// Consumer side. Clears the slot of \a marker and returns its latest value.
+		Event take( const Event &marker );
+
+		/// Number of updates that were folded into a pending one.
+		uint64_t getElidedCount() const		{ return mElidedCount.load( std::memory_order_relaxed ); }
+		void resetStats()					{ mElidedCount.store( 0, std::memory_order_relaxed ); }
+
+	private:
+		// 128 controllers, pitch bend and channel pressure per channel
+		static const int kSlotsPerChannel = 130;
+
+		struct Slot {
+			std::atomic<uint64_t>	event;
+			std::atomic<bool>		pending;
+		};
+
+		static int slotIndex( const Event &event );
+
+		Slot					mSlots[16 * kSlotsPerChannel];
+		std::atomic<uint64_t>	mElidedCount;
+	};
+
+} // namespace midi
+} // namespace cinder
@@ -0,0 +1,115 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "MidiEvent.h"
+
+
+namespace cinder { namespace midi {
+
+	///
+	/// Plain copy of every control of an input, filled by ControllerState::read().
+	///
+	/// Channels are indexed 0 - 15. The changed* masks have one bit per entry that
+	/// was written since the previous read(), so consumers can visit only dirty controls.
+	///
+	struct ControllerSnapshot {
+		uint8_t		notes[16][128];				//< velocity of held notes, 0 when released
+		uint8_t		polyPressure[16][128];
+		uint8_t		controllers[16][128];
+		uint8_t		channelPressure[16];
+		uint8_t		program[16];
+		uint16_t	pitchBend[16];				//< 0 - 16383, 8192 is centered
+
+		uint64_t	changedNotes[16][2];
+		uint64_t	changedPolyPressure[16][2];
+		uint64_t	changedControllers[16][2];
+		uint16_t	changedChannelPressure;		//< one bit per channel
+		uint16_t	changedProgram;
+		uint16_t	changedPitchBend;
+
+		bool isNoteChanged( int channel, int pitch ) const				{ return ( changedNotes[channel][pitch >> 6] >> ( pitch & 63 ) ) & 1; }
+		bool isPolyPressureChanged( int channel, int pitch ) const		{ return ( changedPolyPressure[channel][pitch >> 6] >> ( pitch & 63 ) ) & 1; }
+		bool isControllerChanged( int channel, int control ) const		{ return ( changedControllers[channel][control >> 6] >> ( control & 63 ) ) & 1; }
+	};
+
+	///
+	/// Live table of the last value of every note, controller, pressure, program
+	/// and pitch bend on all 16 channels of an input.
+	///
+	/// update() is called by the single midi thread writer. Individual controls can
+	/// be read from any thread in O(1); read() takes a consistent copy of the whole
+	/// table, guarded by a sequence lock so neither side ever blocks.
+	///
+	class ControllerState {
+	public:
+		ControllerState();
+
+		/// Writer side, called from the midi thread.
+		void update( const Event &event );
+		/// Writer side. Clears every control back to its initial value.
+		void reset();
+
+		/// Copies the whole table into \a snapshot and consumes the changed masks.
+		/// Only one thread should consume the changed masks.
+		void read( ControllerSnapshot &snapshot );
+
+		/// Channels are 1 - 16 as in Event::getChannel().
+		int getNote( int channel, int pitch ) const				{ return mNotes[channel - 1][pitch & 0x7F].load( std::memory_order_relaxed ); }
+		int getPolyPressure( int channel, int pitch ) const		{ return mPolyPressure[channel - 1][pitch & 0x7F].load( std::memory_order_relaxed ); }
+		int getController( int channel, int control ) const		{ return mControllers[channel - 1][control & 0x7F].load( std::memory_order_relaxed ); }
+		int getChannelPressure( int channel ) const				{ return mChannelPressure[channel - 1].load( std::memory_order_relaxed ); }
+		int getProgram( int channel ) const						{ return mProgram[channel - 1].load( std::memory_order_relaxed ); }
+		int getPitchBend( int channel ) const					{ return mPitchBend[channel - 1].load( std::memory_order_relaxed ); }
+
+	private:
+		void beginWrite();
+		void endWrite();
+
+		std::atomic<uint32_t>	mSequence;
+
+		std::atomic<uint8_t>	mNotes[16][128];
+		std::atomic<uint8_t>	mPolyPressure[16][128];
+		std::atomic<uint8_t>	mControllers[16][128];
+		std::atomic<uint8_t>	mChannelPressure[16];
+		std::atomic<uint8_t>	mProgram[16];
+		std::atomic<uint16_t>	mPitchBend[16];
+
+		std::atomic<uint64_t>	mChangedNotes[16][2];
+		std::atomic<uint64_t>	mChangedPolyPressure[16][2];
+		std::atomic<uint64_t>	mChangedControllers[16][2];
+		std::atomic<uint16_t>	mChangedChannelPressure;
+		std::atomic<uint16_t>	mChangedProgram;
+		std::atomic<uint16_t>	mChangedPitchBend;
+	};
+
+} // namespace midi
+} // namespace cinder
@@ -0,0 +1,129 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "MidiEvent.h"
+
+
+namespace cinder { namespace midi {
+
+	///
+	/// What a status byte implies for the rest of its message, see getStatusInfo().
+	///
+	struct StatusInfo {
+		enum Flags : uint8_t {
+			CHANNEL		= 1 << 0,	//< channel voice message, low nibble is the channel
+			SYSEX		= 1 << 1,	//< variable length, runs until MIDI_SYSEX_END
+			REALTIME	= 1 << 2	//< single byte, may appear anywhere in the stream
+		};
+
+		uint8_t		length;		//< total bytes including the status, 0 for data bytes and sysex
+		uint8_t		flags;
+
+		constexpr bool isStatus() const		{ return length != 0 || ( flags & SYSEX ); }
+		constexpr bool isChannel() const	{ return ( flags & CHANNEL ) != 0; }
+		constexpr bool isSysex() const		{ return ( flags & SYSEX ) != 0; }
+		constexpr bool isRealtime() const	{ return ( flags & REALTIME ) != 0; }
+	};
+
+	namespace detail {
+		// a static member of a class template may be defined in a header, so every
+		// translation unit shares the one table
+		template<typename T = void>
+		struct StatusTable {
+			static constexpr uint8_t CH = StatusInfo::CHANNEL;
+			static constexpr uint8_t RT = StatusInfo::REALTIME;
+			static constexpr StatusInfo sInfo[256] = {
+#define ROW( info ) info, info, info, info, info, info, info, info, info, info, info, info, info, info, info, info
+				// 0x00 - 0x7F: data bytes
+				ROW( ( StatusInfo{ 0, 0 } ) ), ROW( ( StatusInfo{ 0, 0 } ) ), ROW( ( StatusInfo{ 0, 0 } ) ), ROW( ( StatusInfo{ 0, 0 } ) ),
+				ROW( ( StatusInfo{ 0, 0 } ) ), ROW( ( StatusInfo{ 0, 0 } ) ), ROW( ( StatusInfo{ 0, 0 } ) ), ROW( ( StatusInfo{ 0, 0 } ) ),
+				ROW( ( StatusInfo{ 3, CH } ) ),		// 0x80 MIDI_NOTE_OFF
+				ROW( ( StatusInfo{ 3, CH } ) ),		// 0x90 MIDI_NOTE_ON
+				ROW( ( StatusInfo{ 3, CH } ) ),		// 0xA0 MIDI_POLY_AFTERTOUCH
+				ROW( ( StatusInfo{ 3, CH } ) ),		// 0xB0 MIDI_CONTROL_CHANGE
+				ROW( ( StatusInfo{ 2, CH } ) ),		// 0xC0 MIDI_PROGRAM_CHANGE
+				ROW( ( StatusInfo{ 2, CH } ) ),		// 0xD0 MIDI_AFTERTOUCH
+				ROW( ( StatusInfo{ 3, CH } ) ),		// 0xE0 MIDI_PITCH_BEND
+#undef ROW
+				// 0xF0 - 0xFF: system messages
+				StatusInfo{ 0, StatusInfo::SYSEX },	// MIDI_SYSEX
+				StatusInfo{ 2, 0 },		// MIDI_TIME_CODE
+				StatusInfo{ 3, 0 },		// MIDI_SONG_POS_POINTER
+				StatusInfo{ 2, 0 },		// MIDI_SONG_SELECT
+				StatusInfo{ 1, 0 },		// undefined
+				StatusInfo{ 1, 0 },		// undefined
+				StatusInfo{ 1, 0 },		// MIDI_TUNE_REQUEST
+				StatusInfo{ 1, 0 },		// MIDI_SYSEX_END
+				StatusInfo{ 1, RT },	// MIDI_TIME_CLOCK
+				StatusInfo{ 1, RT },	// tick, sent by some sequencers
+				StatusInfo{ 1, RT },	// MIDI_START
+				StatusInfo{ 1, RT },	// MIDI_CONTINUE
+				StatusInfo{ 1, RT },	// MIDI_STOP
+				StatusInfo{ 1, RT },	// undefined
+				StatusInfo{ 1, RT },	// MIDI_ACTIVE_SENSING
+				StatusInfo{ 1, RT }		// MIDI_SYSTEM_RESET
+			};
+		};
+
+		template<typename T>
+		constexpr StatusInfo StatusTable<T>::sInfo[256];
+
+		static_assert( sizeof( StatusTable<>::sInfo ) / sizeof( StatusInfo ) == 256, "status table must cover every byte" );
+	}
+
+	/// Constant time lookup into the 256 entry status table.
+	inline constexpr const StatusInfo& getStatusInfo( uint8_t status ){
+		return detail::StatusTable<>::sInfo[status];
+	}
+
+	/// Decodes one complete message as delivered by the driver.
+	/// The length is validated once against the status table, so short or
+	/// malformed messages come back as an Event with status MIDI_UNKNOWN.
+	/// Sysex messages decode to a bare MIDI_SYSEX status.
+	inline Event decode( const uint8_t *bytes, size_t length, uint8_t port = 0, uint32_t time = 0 ){
+		if( length == 0 )
+			return Event( MIDI_UNKNOWN );
+
+		const StatusInfo &info = getStatusInfo( bytes[0] );
+		if( info.isSysex() )
+			return Event( MIDI_SYSEX, 0, 0, port, time );
+		if( info.length == 0 || length < info.length )
+			return Event( MIDI_UNKNOWN );
+
+		// length is validated, unused data bytes are masked to zero
+		const uint8_t data1 = info.length > 1 ? bytes[1] : 0;
+		const uint8_t data2 = info.length > 2 ? bytes[2] : 0;
+		return Event( bytes[0], data1, data2, port, time );
+	}
+
+} // namespace midi
+} // namespace cinder
@@ -0,0 +1,120 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "MidiEvent.h"
+
+
+namespace cinder { namespace midi {
+
+	///
+	/// Typed handler registration with a precomputed dispatch table.
+	///
+	/// Handlers are registered per status, channel and, for control changes, controller
+	/// number. Registration compiles a table indexed by those, so dispatch() looks up
+	/// one slot and calls only the handlers interested in that event, in registration
+	/// order, passing the event by const reference. A note on with velocity 0 goes to
+	/// the note off handlers. Channels are 1 - 16, 0 for all channels.
+	///
+	/// Register handlers before the port is opened; dispatch() doesn't lock.
+	///
+	class Dispatcher {
+	public:
+		typedef std::function<void(const Event&)>	Handler;
+
+		Dispatcher();
+
+		size_t onNoteOn( const Handler &handler )								{ return on( MIDI_NOTE_ON, 0, handler ); }
+		size_t onNoteOn( int channel, const Handler &handler )					{ return on( MIDI_NOTE_ON, channel, handler ); }
+		size_t onNoteOff( const Handler &handler )								{ return on( MIDI_NOTE_OFF, 0, handler ); }
+		size_t onNoteOff( int channel, const Handler &handler )					{ return on( MIDI_NOTE_OFF, channel, handler ); }
+		size_t onPolyAftertouch( const Handler &handler )						{ return on( MIDI_POLY_AFTERTOUCH, 0, handler ); }
+		size_t onControlChange( const Handler &handler )						{ return on( MIDI_CONTROL_CHANGE, 0, handler ); }
+		size_t onControlChange( int channel, int controller, const Handler &handler );
+		size_t onProgramChange( const Handler &handler )						{ return on( MIDI_PROGRAM_CHANGE, 0, handler ); }
+		size_t onAftertouch( const Handler &handler )							{ return on( MIDI_AFTERTOUCH, 0, handler ); }
+		size_t onPitchBend( const Handler &handler )							{ return on( MIDI_PITCH_BEND, 0, handler ); }
+		size_t onPitchBend( int channel, const Handler &handler )				{ return on( MIDI_PITCH_BEND, channel, handler ); }
+		/// Any status, including system messages where \a channel is ignored.
+		/// \return an id for remove(), or 0 when \a status isn't a status byte or \a channel is out of range
+		size_t on( uint8_t status, int channel, const Handler &handler );
+
+		void remove( size_t id );
+		void clear();
+		bool empty() const { return mHandlers.empty(); }
+
+		void dispatch( const Event &event ) const
+		{
+			const int slot = getSlot( event );
+			for( uint32_t i = mOffsets[slot]; i < mOffsets[slot + 1]; ++i )
+				mHandlers[mIndices[i]].handler( event );
+		}
+
+	private:
+		struct Entry {
+			size_t		id;
+			uint8_t		status;
+			uint8_t		channel;	//< 0 for all
+			int16_t		controller;	//< -1 for all
+			Handler		handler;
+		};
+
+		// channel messages by status and channel, control changes by channel and controller, then system messages
+		static const int CONTROLLER_SLOTS	= 7 * 16;
+		static const int SYSTEM_SLOTS		= CONTROLLER_SLOTS + 16 * 128;
+		static const int SLOT_COUNT			= SYSTEM_SLOTS + 16;
+
+		static int getSlot( const Event &event )
+		{
+			uint8_t status = event.getStatus();
+			if( status < MIDI_SYSEX ){
+				const int ch = event.status & 0x0F;
+				if( status == MIDI_CONTROL_CHANGE )
+					return CONTROLLER_SLOTS + ch * 128 + ( event.data1 & 0x7F );
+				if( status == MIDI_NOTE_ON && event.data2 == 0 )
+					status = MIDI_NOTE_OFF;
+				return ( ( status >> 4 ) - 8 ) * 16 + ch;
+			}
+			return SYSTEM_SLOTS + ( status & 0x0F );
+		}
+
+		size_t add( uint8_t status, int channel, int controller, const Handler &handler );
+		void rebuild();
+
+		std::vector<Entry>		mHandlers;
+		std::vector<uint32_t>	mOffsets;	//< SLOT_COUNT + 1 ranges into mIndices
+		std::vector<uint32_t>	mIndices;	//< into mHandlers
+		size_t					mNextId;
+	};
+
+} // namespace midi
+} // namespace cinder
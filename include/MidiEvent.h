@@ -0,0 +1,92 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+#include "MidiConstants.h"
+
+
+namespace cinder { namespace midi {
+
+	///
+	/// Compact, trivially copyable midi event.
+	///
+	/// Holds the raw status byte (channel nibble included), the two data bytes,
+	/// the port index and a 32 bit timestamp offset in microseconds relative to the
+	/// owning Input's time base, all in 8 bytes. Use this rather than Message for
+	/// queues, recordings and anything that copies events around.
+	///
+	struct Event {
+		uint8_t		status;		//< raw status byte
+		uint8_t		data1;
+		uint8_t		data2;
+		uint8_t		port;
+		uint32_t	time;		//< microseconds since the owning Input opened its port, see Input::getTimestampNanos()
+
+		Event() = default;
+		constexpr Event( uint8_t status, uint8_t data1 = 0, uint8_t data2 = 0, uint8_t port = 0, uint32_t time = 0 )
+			: status( status ), data1( data1 ), data2( data2 ), port( port ), time( time )
+		{}
+
+		/// true for channel voice messages (0x80 - 0xEF)
+		constexpr bool		isChannelMessage() const	{ return status >= MIDI_NOTE_OFF && status < MIDI_SYSEX; }
+		/// Status type as in MidiStatus, ie. with the channel nibble stripped for channel messages.
+		constexpr int		getStatus() const			{ return isChannelMessage() ? ( status & 0xF0 ) : status; }
+		/// 1 - 16, or 0 for system messages
+		constexpr int		getChannel() const			{ return isChannelMessage() ? ( status & 0x0F ) + 1 : 0; }
+		constexpr int		getPitch() const			{ return data1; }
+		constexpr int		getVelocity() const			{ return data2; }
+		constexpr int		getControl() const			{ return data1; }
+		/// Slot of a MIDI_SYSEX event in the owning Input's SysexPool.
+		constexpr int		getSysexHandle() const		{ return ( data2 << 7 ) | data1; }
+		/// Depends on status type: control and key pressure values, program number,
+		/// channel pressure, 14 bit pitch bend (0 - 16383) or the song position.
+		constexpr int		getValue() const
+		{
+			return ( getStatus() == MIDI_PITCH_BEND || getStatus() == MIDI_SONG_POS_POINTER ) ? ( ( data2 << 7 ) | data1 )
+				: ( getStatus() == MIDI_PROGRAM_CHANGE || getStatus() == MIDI_AFTERTOUCH || getStatus() == MIDI_TIME_CODE || getStatus() == MIDI_SONG_SELECT ) ? data1
+				: data2;
+		}
+		/// Number of bytes this event occupies on the wire, or 0 for sysex.
+		constexpr size_t	getSize() const
+		{
+			return ( getStatus() == MIDI_SYSEX ) ? 0
+				: ( getStatus() == MIDI_PROGRAM_CHANGE || getStatus() == MIDI_AFTERTOUCH || getStatus() == MIDI_TIME_CODE || getStatus() == MIDI_SONG_SELECT ) ? 2
+				: ( status > MIDI_SONG_SELECT ) ? 1		// as the decoder table, including undefined 0xF4 / 0xF5
+				: 3;
+		}
+	};
+
+	static_assert( sizeof( Event ) == 8, "midi::Event is expected to pack into 8 bytes" );
+	static_assert( std::is_trivially_copyable<Event>::value, "midi::Event must stay trivially copyable" );
+
+} // namespace midi
+} // namespace cinder
@@ -0,0 +1,105 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "MidiEvent.h"
+
+
+namespace cinder { namespace midi {
+
+	///
+	/// Compiled input filter, see Input::setFilter().
+	///
+	/// Evaluated on the midi thread straight after decoding, so a rejected event
+	/// costs a couple of bit tests and never reaches a signal, queue or table.
+	///
+	struct Filter {
+		uint16_t	channels;		//< bit n accepts channel n + 1
+		uint32_t	statuses;		//< see getStatusBit()
+		uint64_t	controllers[2];	//< control change numbers 0 - 127
+
+		/// Accepts everything.
+		Filter() : channels( 0xFFFF ), statuses( 0xFFFFFFFF ), controllers{ ~uint64_t( 0 ), ~uint64_t( 0 ) } {}
+
+		/// Channel messages map to bits 0 - 6 by status type, system messages 0xF0 - 0xFF to bits 16 - 31.
+		/// A data byte (below 0x80) has no bit and maps to 0.
+		static uint32_t getStatusBit( int status )
+		{
+			if( status < 0x80 )
+				return 0;
+			return status >= MIDI_SYSEX ? ( 1u << ( 16 + ( status & 0x0F ) ) ) : ( 1u << ( ( ( status >> 4 ) & 0x0F ) - 8 ) );
+		}
+
+		/// Accepts nothing; enable what you need with the setters below.
+		static Filter none()
+		{
+			Filter filter;
+			filter.channels = 0;
+			filter.statuses = 0;
+			filter.controllers[0] = filter.controllers[1] = 0;
+			return filter;
+		}
+
+		/// Channels are 1 - 16.
+		Filter& setChannel( int channel, bool accept = true )
+		{
+			const uint16_t bit = uint16_t( 1 << ( ( channel - 1 ) & 0x0F ) );
+			channels = accept ? ( channels | bit ) : ( channels & ~bit );
+			return *this;
+		}
+		/// \a status is a MidiStatus type, eg. MIDI_NOTE_ON or MIDI_TIME_CLOCK.
+		Filter& setStatus( int status, bool accept = true )
+		{
+			const uint32_t bit = getStatusBit( status );
+			statuses = accept ? ( statuses | bit ) : ( statuses & ~bit );
+			return *this;
+		}
+		Filter& setController( int control, bool accept = true )
+		{
+			const uint64_t bit = uint64_t( 1 ) << ( control & 63 );
+			uint64_t &word = controllers[( control >> 6 ) & 1];
+			word = accept ? ( word | bit ) : ( word & ~bit );
+			return *this;
+		}
+
+		bool accepts( const Event &event ) const
+		{
+			if( !event.isChannelMessage() )
+				return ( statuses & getStatusBit( event.status ) ) != 0;
+			if( !( ( channels >> ( event.status & 0x0F ) ) & 1 ) || !( statuses & getStatusBit( event.status ) ) )
+				return false;
+			if( ( event.status & 0xF0 ) == MIDI_CONTROL_CHANGE )
+				return ( ( controllers[event.data1 >> 6] >> ( event.data1 & 63 ) ) & 1 ) != 0;
+			return true;
+		}
+	};
+
+} // namespace midi
+} // namespace cinder
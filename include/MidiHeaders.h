@@ -32,8 +32,26 @@ Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
 
 #include "MidiConstants.h"
 #include "MidiExceptions.h"
+#include "MidiEvent.h"
+#include "MidiDecoder.h"
+#include "MidiDispatcher.h"
+#include "MidiFilter.h"
+#include "MidiStreamParser.h"
 #include "MidiMessage.h"
+#include "MidiRingBuffer.h"
+#include "MidiCoalescer.h"
+#include "MidiParameterAssembler.h"
+#include "MidiSysexPool.h"
+#include "MidiLatency.h"
+#include "MidiControllerState.h"
+#include "MidiActiveNotes.h"
+#include "MidiClockTracker.h"
+#include "MidiTimecodeTracker.h"
+#include "MidiMpeTracker.h"
+#include "MidiRateLimiter.h"
 #include "RtMidi.h"
+#include "MidiPortRegistry.h"
 #include "MidiIn.h"
+#include "MidiBasicInput.h"
 #include "MidiOut.h"
 #include "MidiHub.h"
@@ -48,12 +48,26 @@ namespace cinder { namespace midi {
 		bool	isConnected()				{ return (midiInPool.size() > 0 ? true : false); };
 		bool	isDeviceConnected( std::string _name );
 		
-		//bool	hasWaitingMessages();
-		//bool	getNextMessage( Message *msg );
+		/// Enables pull mode on every connected input (reconnects them).
+		void	setPollingEnabled( bool enabled, size_t capacity = 1024 );
+		bool	hasWaitingMessages();
+		bool	getNextMessage( Message *msg );
+		/// Drains up to \a max events from all inputs, see Input::poll().
+		/// Each MIDI_SYSEX event holds a slot in its input's sysex pool: read it with
+		/// getSysexData() and hand it back with releaseSysex(), or the pool runs dry.
+		size_t	poll( Event *out, size_t max );
+		/// Route through Event::port to the input that received \a event. No-op, or nullptr
+		/// and 0, for other events and once that input is disconnected.
+		const uint8_t*	getSysexData( const Event &event ) const;
+		size_t			getSysexSize( const Event &event ) const;
+		void			releaseSysex( const Event &event );
 		
 	protected:
 		
-		RtMidiIn	midii;
+		Input*		findInput( uint8_t port ) const;
+		
+		bool		mPolling { false };
+		size_t		mPollCapacity { 1024 };
 		
 		std::vector<midi::Input*>	midiInPool;
 		//vector<midi::Output*>		midiOutPool;
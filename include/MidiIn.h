@@ -34,6 +34,10 @@ Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
 #include <vector>
 #include <string>
 #include <iostream>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
 
 #include "MidiHeaders.h"
 #include "cinder/Signals.h"
@@ -43,6 +47,14 @@ Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
 
 namespace cinder { namespace midi {
 
+/// What the midi thread does when the main thread falls behind and its queue is full.
+enum OverflowPolicy {
+    OVERFLOW_DROP_NEWEST,           // the incoming event is dropped
+    OVERFLOW_DROP_OLDEST,           // the oldest waiting event makes room for it
+    OVERFLOW_COALESCE_CONTROLLERS,  // controllers fold into last-value-wins slots, other events drop newest
+    OVERFLOW_BLOCK                  // the midi thread waits for room, up to a timeout, then drops newest
+};
+
 void MidiInCallback( double deltatime, std::vector< unsigned char > *message, void *userData );
 
 class Input {
@@ -50,33 +62,254 @@ public:
 	Input();
 	virtual ~Input();
 	
+	/// Called from the midi callback; picks up the driver timestamp where RtMidi provides one.
 	void processMessage(double deltatime, std::vector<unsigned char> *message);
+	/// As above, with an explicit driver timestamp on the getNowNanos() clock, or 0 if unknown.
+	void processMessage(double deltatime, std::vector<unsigned char> *message, uint64_t driverNanos);
+	/// Runs an already decoded event through the signals and queues as if it came from the port.
+	/// Must not run concurrently with the midi callback.
+	void processEvent(const Event &event);
 	void listPorts();
 	void openPort(unsigned int port = 0);
+	/// Opens the input with this name, see PortRegistry.
+	void openPort(const std::string &name);
 	void closePort();
     
     void setDispatchToMainThread(bool shouldDispatch) { mDispatchToMainThread = shouldDispatch; }
+    
+    /// Main thread delivery goes through a preallocated ring of \a capacity messages. Batched,
+    /// it is drained once per app update(); otherwise a single dispatchAsync() drains whatever
+    /// is waiting, so a stalled main thread never queues more than one task per input.
+    /// Call before openPort().
+    void setBatchedDelivery(bool batched, size_t capacity = 4096);
+    bool isBatchedDelivery() const { return mBatched; }
+    /// Drains the queue and emits midiBatchSignal followed by midiSignal for each message,
+    /// then reports parameters whose LSB is overdue. Connected to the app's update signal
+    /// automatically when batched delivery or parameter assembly is enabled.
+    void update();
+    
+    /// Bounds the main thread queue to \a capacity messages and picks what happens when it is
+    /// full. \a blockTimeoutMicros only applies to OVERFLOW_BLOCK. The default is
+    /// OVERFLOW_DROP_NEWEST at 4096 messages. Call before openPort().
+    void setOverflowPolicy(OverflowPolicy policy, size_t capacity = 4096, uint32_t blockTimeoutMicros = 1000);
+    OverflowPolicy getOverflowPolicy() const { return mOverflowPolicy; }
+    
+    /// Largest number of messages seen waiting in the main thread queue.
+    size_t getQueueHighWaterMark() const { return mQueueHighWaterMark.load(std::memory_order_relaxed); }
+    /// Number of messages queued for the main thread.
+    uint64_t getQueueEnqueuedCount() const { return mQueueEnqueuedCount.load(std::memory_order_relaxed); }
+    /// Number of messages dropped because the main thread queue was full, by any policy.
+    uint64_t getQueueOverflowCount() const { return mQueueOverflowCount.load(std::memory_order_relaxed); }
+    void resetQueueStats();
+    
+    /// Monotonic clock used for event timestamps, in nanoseconds.
+    static uint64_t getNowNanos();
+    /// Absolute getNowNanos() time at which \a event reached the midi callback.
+    /// Event::time is a 32 bit microsecond offset from when the port was opened, so this
+    /// is exact for events younger than ~71 minutes.
+    uint64_t getTimestampNanos(const Event &event) const;
+    /// Maps a getNowNanos() time onto the app clock, ie. app::getElapsedSeconds().
+    double toAppTime(uint64_t nanos) const;
+    double toAppTime(const Event &event) const { return toAppTime(getTimestampNanos(event)); }
+    
+    /// Records per-stage input latencies into lock-free histograms. Off by default;
+    /// when off no clock is read and nothing is recorded. Call before openPort().
+    void setLatencyInstrumentation(bool enabled);
+    bool isLatencyInstrumented() const { return mLatency != nullptr; }
+    /// \return nullptr unless instrumentation is enabled
+    const LatencyHistogram* getLatencyHistogram(LatencyStage stage) const;
+    void resetLatency();
+    
+    /// Collapses control change, pitch bend and channel pressure updates into last-value-wins
+    /// slots until the main thread picks them up. Notes and sysex keep their order.
+    /// Only affects main thread delivery. Call before openPort().
+    void setCoalescing(bool coalesce);
+    bool isCoalescing() const { return mCoalescer != nullptr; }
+    /// Number of updates dropped in favour of a newer value.
+    uint64_t getCoalescedCount() const { return mCoalescer ? mCoalescer->getElidedCount() : 0; }
+    
+    /// Assembles CC MSB/LSB pairs and RPN/NRPN sequences into single ParameterEvents on
+    /// midiParameterThreadSignal / midiParameterSignal. With \a consumeControllers the
+    /// control changes that make up a parameter are not delivered as Events themselves.
+    /// Main thread parameters share the bounded queue and overflow policy with the events.
+    /// An MSB left waiting when traffic stops is reported from update() once its LSB is
+    /// overdue, on both signals from the main thread. Call before openPort().
+    void setParameterAssembly(bool enabled, uint32_t lsbTimeoutMicros = 10000, bool consumeControllers = false);
+    bool isParameterAssembly() const { return mParameterAssembler != nullptr; }
+    
+    /// Pull mode: every event is also pushed into a wait-free ring of \a capacity events
+    /// that the consumer drains with poll(), eg. from a render loop or audio callback.
+    /// Call before openPort().
+    void setPollingEnabled(bool enabled, size_t capacity = 1024);
+    bool isPollingEnabled() const { return mPollQueue != nullptr; }
+    /// Pops up to \a max waiting events into \a out without locking or allocating.
+    /// Must only be called from one thread at a time.
+    /// \return the number of events written
+    size_t poll(Event *out, size_t max);
+    bool hasWaitingMessages() const;
+    /// Polls one event as a Message. A MIDI_SYSEX payload stays readable with
+    /// getSysexData( message.toEvent() ) until the next call, which releases its slot.
+    bool getNextMessage(Message *message);
+    /// Number of events dropped because nobody polled the queue in time.
+    uint64_t getPollOverflowCount() const { return mPollOverflowCount.load(std::memory_order_relaxed); }
+    
+    /// Sysex payloads are kept in a recycled pool; MIDI_SYSEX events only carry a handle.
+    /// Replaces the default pool of 16 slots of 4 KB, call before openPort().
+    void setSysexPool(size_t slotCount, size_t slotSize);
+    SysexPool& getSysexPool() { return *mSysexPool; }
+    /// Payload of a MIDI_SYSEX event, including the MIDI_SYSEX and MIDI_SYSEX_END bytes.
+    /// Valid while the event is being delivered, or until releaseSysex() for polled events.
+    const uint8_t* getSysexData(const Event &event) const;
+    size_t getSysexSize(const Event &event) const;
+    /// Polled MIDI_SYSEX events hold a pool slot until released. No-op for other events.
+    void releaseSysex(const Event &event);
+    
+    /// Last value of every note, controller, pressure, program and pitch bend on all channels,
+    /// kept up to date on the midi thread and readable from any thread without a signal.
+    ControllerState& getControllerState() { return mControllerState; }
+    
+    /// Tracks MPE zones and a per-note voice table with live pitch bend, pressure and
+    /// timbre, readable lock-free from the render thread. Call before openPort().
+    void setMpeTracking(bool enabled);
+    /// nullptr unless MPE tracking is enabled.
+    MpeTracker* getMpeTracker() { return mMpeTracker.get(); }
+    
+    /// Follows MIDI clock and transport messages on the midi thread. With \a consumeClock
+    /// clock ticks stop there instead of being delivered one by one. Call before openPort().
+    void setClockTracking(bool enabled, bool consumeClock = false);
+    /// nullptr unless clock tracking is enabled.
+    ClockTracker* getClockTracker() { return mClockTracker.get(); }
+    /// Quarter notes since song start and the position within the current beat, interpolated
+    /// to now. Lock-free, 0 unless clock tracking is enabled.
+    double getBeats() const;
+    double getBeatPhase() const;
+    
+    /// Follows MIDI time code, both quarter frames and full frame sysex, on the midi thread.
+    /// With \a consumeQuarterFrames those stop there instead of being delivered one by one.
+    /// Call before openPort().
+    void setTimecodeTracking(bool enabled, bool consumeQuarterFrames = false);
+    /// nullptr unless timecode tracking is enabled.
+    TimecodeTracker* getTimecodeTracker() { return mTimecodeTracker.get(); }
+    /// Timecode position in seconds, interpolated to now. Lock-free, 0 unless tracking is enabled.
+    double getTimecodeSeconds() const;
+    /// false once quarter frames have stopped for Timecode::TIMEOUT, or unless tracking is enabled.
+    bool isTimecodeRunning() const;
+    
+    /// Notes currently held on this input. A note on with velocity 0 counts as a note off.
+    ActiveNotes& getActiveNotes() { return mActiveNotes; }
+    /// Delivers a note off for every note held longer than \a maxHeldSeconds through
+    /// processEvent(), so the tables, the poll queue and all signals see it. The midi
+    /// thread signals fire on the calling thread for these. \return the number of notes released
+    int releaseStuckNotes(double maxHeldSeconds);
+    /// When enabled closePort() delivers a note off for every held note through the usual
+    /// signals and queues, so downstream state doesn't leak. Off by default.
+    void setReleaseNotesOnClose(bool enabled) { mReleaseNotesOnClose = enabled; }
 	
 	unsigned int getNumPorts()const{ return mNumPorts; }
 	unsigned int getPort()const;
 	void ignoreTypes(bool sysex, bool time, bool midisense);
 	
+	/// Drops events on the midi thread before any table, signal or queue sees them.
+	/// Finer grained than ignoreTypes(): channels, status types and controller numbers.
+	/// Safe to change from any thread while the port is open; the midi thread always
+	/// sees either the previous filter or the new one, never a mix.
+	void setFilter(const Filter &filter);
+	void clearFilter();
+	Filter getFilter() const;
+	/// Number of events rejected by the filter.
+	uint64_t getFilteredCount() const { return mFilteredCount.load(std::memory_order_relaxed); }
+	
+	/// Filled by listPorts().
 	std::vector<std::string> mPortNames;
 	std::string getName()	{ return mName; };
 	std::string getPortName(int number);
     
     signals::Signal<void(Message)>      midiThreadSignal;   // Will be called from the Midi thread
     signals::Signal<void(Message)>      midiSignal;         // Will be called from the Main thread
+    signals::Signal<void(const Event&)> midiEventThreadSignal;  // Compact event, Midi thread
+    signals::Signal<void(const Event&)> midiEventSignal;        // Compact event, Main thread
+    signals::Signal<void(const std::vector<Event>&)> midiBatchSignal; // Main thread, once per drained queue
+    signals::Signal<void(const ParameterEvent&)> midiParameterThreadSignal;    // 14 bit CC / RPN / NRPN, Midi thread
+    signals::Signal<void(const ParameterEvent&)> midiParameterSignal;          // 14 bit CC / RPN / NRPN, Main thread
+    
+    /// Typed handlers, eg. midiHandlers.onControlChange( 1, 7, fn ), called only for the events
+    /// they registered for. Register before openPort().
+    Dispatcher                          midiThreadHandlers; // Midi thread
+    Dispatcher                          midiHandlers;       // Main thread
 	
 
 protected:
 	
+	void dispatchMainThread(const Event &event);
+	bool enqueueMainThread(const Event &event);
+	void resetMainQueue(size_t capacity);
+	void drainMainQueue();
+	void discardMainThread(const Event &event);
+	void retainSysex(const Event &event);
+	void emitParameter(const ParameterEvent &parameter);
+	bool takeParameter(const Event &marker, ParameterEvent *parameter);
+	void expireParameters();
+	void connectUpdate();
+	void recordMainThreadLatency(const Event &event);
+	bool passesFilter(const Event &event) const;
+	/// Consistent copy of the filter fields. \return whether the filter is enabled
+	bool readFilter(Filter &filter) const;
+	
 	RtMidiIn*       mMidiIn;
 	unsigned int    mNumPorts;
 	unsigned int    mPort;
 	std::string     mName;
     
     bool            mDispatchToMainThread { true };
+    
+    uint64_t        mEpochNanos { 0 };          // getNowNanos() when the port was opened
+    double          mEpochAppSeconds { 0.0 };   // app clock at the same moment
+    
+    std::unique_ptr<Coalescer>              mCoalescer;
+    std::unique_ptr<ParameterAssembler>     mParameterAssembler;
+    std::mutex                              mProducerMutex;     // lets other threads stand in for the midi thread
+    std::mutex                              mParameterMutex;    // the main thread expires what the midi thread assembles
+    bool                                    mConsumeParameterControllers { false };
+    struct QueuedParameter { uint32_t sequence; ParameterEvent parameter; };
+    // main thread parameters wait here; a MIDI_UNKNOWN marker carrying the sequence holds their place in mMainQueue
+    std::unique_ptr<RingBuffer<QueuedParameter>> mParameterQueue;
+    uint32_t                                mParameterSequence { 0 };
+    std::unique_ptr<RingBuffer<Event>>      mMainQueue;     // twice mQueueLimit, the headroom serves OVERFLOW_DROP_OLDEST
+    size_t                                  mQueueLimit { 0 };
+    OverflowPolicy                          mOverflowPolicy { OVERFLOW_DROP_NEWEST };
+    uint32_t                                mBlockTimeoutMicros { 1000 };
+    std::atomic<size_t>                     mDropOldestCount { 0 };    // events the consumer skips at the front
+    std::atomic<bool>                       mDrainScheduled { false };
+    bool                                    mBatched { false };
+    std::unique_ptr<Event[]>                mDrainBuffer;   // raw storage the queue is popped into, mMainQueue->capacity()
+    std::vector<Event>                      mBatch;         // reserved once, what midiBatchSignal hands out
+    signals::ScopedConnection               mUpdateConnection;
+    std::atomic<size_t>                     mQueueHighWaterMark { 0 };
+    std::atomic<uint64_t>                   mQueueEnqueuedCount { 0 };
+    std::atomic<uint64_t>                   mQueueOverflowCount { 0 };
+    
+    std::atomic<bool>                       mFilterEnabled { false };
+    std::atomic<uint16_t>                   mFilterChannels { 0xFFFF };
+    std::atomic<uint32_t>                   mFilterStatuses { 0xFFFFFFFF };
+    std::atomic<uint64_t>                   mFilterControllers[2];
+    std::atomic<uint32_t>                   mFilterSequence { 0 };  // sequence lock over the filter fields
+    std::mutex                              mFilterMutex;           // serializes setFilter() and clearFilter()
+    std::atomic<uint64_t>                   mFilteredCount { 0 };
+    
+    ControllerState                         mControllerState;
+    std::unique_ptr<MpeTracker>             mMpeTracker;
+    std::unique_ptr<ClockTracker>           mClockTracker;
+    bool                                    mConsumeClock { false };
+    std::unique_ptr<TimecodeTracker>        mTimecodeTracker;
+    bool                                    mConsumeQuarterFrames { false };
+    ActiveNotes                             mActiveNotes;
+    bool                                    mReleaseNotesOnClose { false };
+    std::unique_ptr<SysexPool>              mSysexPool;
+    std::unique_ptr<LatencyHistogram[]>     mLatency;   // one per LatencyStage when instrumented
+    
+    std::unique_ptr<RingBuffer<Event>>      mPollQueue;
+    std::atomic<uint64_t>                   mPollOverflowCount { 0 };
+    Event                                   mPolledSysex { 0 };   // last sysex handed out by getNextMessage()
 
 };
 
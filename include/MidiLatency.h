@@ -0,0 +1,78 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+
+namespace cinder { namespace midi {
+
+	/// Stages of the input path that Input can time, see Input::setLatencyInstrumentation().
+	enum LatencyStage {
+		LATENCY_DRIVER_TO_CALLBACK,			//< driver timestamp to midi callback entry; ALSA and CoreMIDI only
+		LATENCY_CALLBACK_TO_THREAD_SIGNAL,	//< callback entry until the midi thread signals have returned
+		LATENCY_CALLBACK_TO_MAIN_THREAD,	//< callback entry until the main thread signals fire
+		LATENCY_STAGE_COUNT
+	};
+
+	///
+	/// Lock-free log-linear histogram of nanosecond durations.
+	///
+	/// Values below 16 ns are counted exactly; above that every power of two is split
+	/// into 8 linear buckets, so any percentile is reported within 12.5%. record()
+	/// is a handful of relaxed atomic increments and safe from any thread.
+	///
+	class LatencyHistogram {
+	public:
+		LatencyHistogram();
+
+		void		record( uint64_t nanos );
+		void		reset();
+
+		uint64_t	getCount() const	{ return mCount.load( std::memory_order_relaxed ); }
+		uint64_t	getMax() const		{ return mMax.load( std::memory_order_relaxed ); }
+		double		getMean() const;
+		/// \a percentile in 0 - 100, eg. 50 or 99. \return nanoseconds, 0 if nothing was recorded
+		uint64_t	getPercentile( double percentile ) const;
+
+	private:
+		static const size_t BUCKET_COUNT = 16 + 60 * 8;
+
+		static size_t	bucketIndex( uint64_t nanos );
+		static uint64_t	bucketUpperBound( size_t index );
+
+		std::atomic<uint64_t>	mBuckets[BUCKET_COUNT];
+		std::atomic<uint64_t>	mCount;
+		std::atomic<uint64_t>	mSum;
+		std::atomic<uint64_t>	mMax;
+	};
+
+} // namespace midi
+} // namespace cinder
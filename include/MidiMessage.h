@@ -28,6 +28,8 @@ POSSIBILITY OF SUCH DAMAGE.
 
 #pragma once
 
+#include "MidiEvent.h"
+
 
 namespace cinder { namespace midi {
 
@@ -35,18 +37,21 @@ namespace cinder { namespace midi {
 	public:
 
 		Message();
+		Message(const Event& event);
 
 		int port;
 		int channel;
 		int status;
 		int byteOne;
 		int byteTwo;
-		double timeStamp;
+		double timeStamp;	//< seconds since the port was opened
 		int pitch;			//< 0 - 127
 		int velocity;		//< 0 - 127
 		int control;		//< 0 - 127
 		int value;			//< depends on message status type
 		Message& copy(const Message& other);
+		/// Packs this message back into a compact Event.
+		Event toEvent() const;
 	};
 
 } // namespace midi
@@ -0,0 +1,119 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "MidiEvent.h"
+#include "MidiParameterAssembler.h"
+
+
+namespace cinder { namespace midi {
+
+	/// One sounding note and its live per-note expression.
+	struct MpeVoice {
+		uint8_t		channel;	//< 1 - 16
+		uint8_t		note;
+		uint8_t		velocity;
+		uint8_t		pressure;	//< channel pressure of the note's channel
+		uint8_t		timbre;		//< CC 74 of the note's channel
+		uint16_t	pitchBend;	//< 0 - 16383 of the note's channel, 8192 is centered
+		uint32_t	time;		//< note on, same time base as Event::time
+	};
+
+	/// An MPE zone. The lower zone is managed on channel 1 with members from channel 2 up,
+	/// the upper zone on channel 16 with members from channel 15 down.
+	struct MpeZone {
+		uint8_t		memberChannels;			//< 0 when the zone is off
+		float		memberBendRange;		//< semitones, RPN 0 on a member channel
+		float		managerBendRange;		//< semitones, RPN 0 on the manager channel
+		uint16_t	managerPitchBend;		//< zone wide pitch bend on the manager channel
+	};
+
+	/// Consistent copy of the voice table, see MpeTracker::read().
+	struct MpeSnapshot {
+		static const int MAX_VOICES = 64;
+
+		MpeVoice	voices[MAX_VOICES];
+		int			voiceCount;
+		MpeZone		lowerZone;
+		MpeZone		upperZone;
+
+		/// Pitch of \a voice in fractional semitones, including member and zone wide pitch bend.
+		float getPitch( const MpeVoice &voice ) const;
+	};
+
+	///
+	/// Tracks MPE zones and per-note expression from the input's events.
+	///
+	/// Zones follow MPE configuration messages (RPN 6 on channel 1 or 16) and pitch
+	/// bend ranges follow RPN 0; both can also be set up front. Every held note gets a
+	/// slot in a fixed capacity voice table which tracks its channel's pitch bend,
+	/// pressure and timbre (CC 74). process() runs on the midi thread and never
+	/// allocates; the table is published through a triple buffer, so read() is
+	/// lock-free from any single reader thread, eg. the render loop.
+	///
+	class MpeTracker {
+	public:
+		/// Defaults to a lower zone with all 15 member channels, as most controllers assume.
+		MpeTracker();
+
+		/// Midi thread.
+		void process( const Event &event );
+		/// Zone layout as an MPE configuration message would set it.
+		void setZones( int lowerMemberChannels, int upperMemberChannels );
+
+		/// Reader thread. Returns the latest published table, valid until the next read().
+		const MpeSnapshot& read();
+
+	private:
+		void configureZone( MpeZone &zone, int memberChannels );
+		void onParameter( const ParameterEvent &parameter );
+		MpeZone* getZone( int channel, bool *isManager );
+		void noteOn( int channel, int note, int velocity, uint32_t time );
+		void noteOff( int channel, int note );
+		void publish();
+
+		// per channel expression, applied to notes as they start
+		uint16_t			mPitchBend[16];
+		uint8_t				mPressure[16];
+		uint8_t				mTimbre[16];
+
+		ParameterAssembler	mParameters;
+
+		// triple buffer: the writer fills mBuffers[mBack], then swaps it with the middle one
+		MpeSnapshot			mBuffers[3];
+		int					mBack;
+		int					mFront;
+		std::atomic<int>	mMiddle;	//< index, plus FRESH when newer than the front
+		static const int FRESH = 4;
+	};
+
+} // namespace midi
+} // namespace cinder
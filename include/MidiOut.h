@@ -26,6 +26,11 @@ Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
 
 #pragma once
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
 #include "cinder/app/App.h"
 
 #include "MidiHeaders.h"
@@ -67,6 +72,9 @@ public:
 	/// Setting port = 0 will open the first available
 	bool openPort(unsigned int portNumber=0);
 	
+	/// Connect to an output port by name.
+	bool openPort(std::string const& portName);
+	
 	/// Create and connect to a virtual output port (MacOS and Linux ALSA only).
 	/// allows for connections between software
 	/// note: a connected virtual port has a portNum = -1
@@ -121,22 +129,175 @@ public:
 	void sendPolyAftertouch(int channel, int pitch, int value);
 	
 	/// Low level access
-	void sendMessage(std::vector<unsigned char>& bytes);
+	///
+	/// In the default mode none of these allocate or lock: the bytes go straight to the
+	/// backend's encoder (sysex on Windows excepted), so they are safe to call from an audio
+	/// thread, from one thread at a time. In async output mode channel messages stay lock-free
+	/// but sysex takes a lock and copies its payload. Rate limited sends briefly take a lock
+	/// shared with the pacer thread, and sysex copies its payload as well.
+	void sendMessage(const uint8_t* bytes, size_t size);
+	void sendMessage(const std::vector<unsigned char>& bytes);
 	void sendMessage(unsigned char status, unsigned char byteOne);
 	void sendMessage(unsigned char status, unsigned char byteOne, unsigned char byteTwo);
+	/// Sends a compact event, eg. one received from a midi::Input. Sysex events are ignored.
+	void sendMessage(const Event& event);
+	
+	/// Sends \a count events and hands them to the driver in one go where the API buffers
+	/// output (ALSA drains once instead of once per message).
+	void sendBatch(const Event* events, size_t count);
+	void sendBatch(const std::vector<Event>& events) { sendBatch(events.data(), events.size()); }
+	/// Everything sent between beginBatch() and flush() is delivered together.
+	/// Nests; only the outermost flush() delivers. Ignored in async output and rate limited
+	/// modes, where a background thread batches on its own.
+	void beginBatch();
+	void flush();
+	
+	/// Keeps track of the notes sent through this port. closePort() then sends a note off
+	/// for every note still held.
+	void setNoteTracking(bool enabled) { mNoteTracking = enabled; }
+	const ActiveNotes& getActiveNotes() const { return mActiveNotes; }
+	
+	/// \section Scheduling
+	
+	/// Starts a dispatcher thread that sends events queued with sendAt() on time, independent
+	/// of the frame rate. Room for \a capacity pending events, the ones waiting in the ALSA
+	/// queue included, is allocated up front. Disabling drops whatever is still pending.
+	///
+	/// note: the dispatcher sends from its own thread, so while scheduling is enabled send
+	///		  everything through sendAt(), using a time of 0 for "now".
+	void setScheduling(bool enabled, size_t capacity=4096);
+	bool isScheduling() const { return mDispatcher.joinable(); }
+	
+	/// Sends \a event at \a nanos on the Input::getNowNanos() clock. On ALSA the event goes
+	/// straight to the sequencer's real-time queue and is timed by the kernel; elsewhere it
+	/// waits in the dispatcher's queue. Times in the past are sent right away.
+	/// With note tracking on, a scheduled note counts once its time has come.
+	/// \return false if scheduling is off, the queue is full or the event is a sysex
+	bool sendAt(uint64_t nanos, const Event& event);
+	/// Drops the events still waiting, in the dispatcher's queue or the ALSA queue.
+	/// closePort() does the same.
+	void clearSchedule();
+	size_t getScheduledCount() const;
+	
+	/// \section Async output
+	
+	/// In async mode every send only enqueues into a lock-free ring of \a capacity events, and
+	/// a writer thread drains it to the driver in batches, so a slow device never stalls the
+	/// caller. Any number of threads may send at once. When the ring is full a send waits up
+	/// to \a blockTimeoutMicros for room (0 = drop right away) and is then counted as dropped.
+	/// Sysex messages go through a small locked side queue but keep their place in the stream.
+	///
+	/// Call while no other thread is sending. Disabling writes out what is still queued.
+	void setAsyncOutput(bool enabled, size_t capacity=4096, uint32_t blockTimeoutMicros=0);
+	bool isAsyncOutput() const { return mAsyncQueue != nullptr; }
+	/// Blocks until everything enqueued so far has been written to the driver.
+	/// \return false if that took longer than \a timeoutMicros
+	bool waitForOutput(uint32_t timeoutMicros);
+	
+	/// Approximate number of events waiting for the writer thread.
+	size_t getOutputQueueDepth() const { return mAsyncQueue ? mAsyncQueue->size() : 0; }
+	uint64_t getOutputEnqueuedCount() const { return mOutputEnqueuedCount.load(std::memory_order_relaxed); }
+	uint64_t getOutputWrittenCount() const { return mOutputWrittenCount.load(std::memory_order_relaxed); }
+	uint64_t getOutputDroppedCount() const { return mOutputDroppedCount.load(std::memory_order_relaxed); }
+	/// Time the last written event spent in the queue, and the worst so far, in nanoseconds.
+	uint64_t getOutputLagNanos() const { return mOutputLagNanos.load(std::memory_order_relaxed); }
+	uint64_t getMaxOutputLagNanos() const { return mMaxOutputLagNanos.load(std::memory_order_relaxed); }
+	/// Resets the dropped count and the lag figures.
+	void resetOutputStats();
+	
+	/// \section Rate limiting
+	
+	/// Paces output to \a bytesPerSecond, DIN MIDI speed by default, through a RateLimiter:
+	/// controller, pitch bend and pressure updates are thinned to the latest value per
+	/// channel and controller, repeats of the value last sent are dropped, and notes always
+	/// go out first. A pacer thread sends whatever the budget allows, so controller updates
+	/// can be sent every frame without delaying notes behind a backlog.
+	///
+	/// Sysex waits in order with the notes, in a FIFO with room for \a queueCapacity
+	/// events; sends that find it full are dropped, see RateLimiter::getDroppedCount().
+	/// Call while no other thread is sending. Disabling, like closePort(), sends everything
+	/// still pending.
+	void setRateLimit(bool enabled, double bytesPerSecond=RateLimiter::kDinBytesPerSecond, size_t queueCapacity=1024);
+	bool isRateLimited() const { return mRateLimiter != nullptr; }
+	/// \return nullptr unless rate limiting is on. From other threads only read its counters.
+	const RateLimiter* getRateLimiter() const { return mRateLimiter.get(); }
 	
 	static bool sVerboseLogging;
 private:
+	struct Queued
+	{
+		uint64_t time; ///< Input::getNowNanos() when enqueued
+		Event event;   ///< MIDI_SYSEX stands for the front of mAsyncSysex
+	};
+	bool enqueue(const uint8_t* bytes, size_t size);
+	void write();
+	/// Hands bytes on past the rate limiter, to the async queue or the driver.
+	void output(const uint8_t* bytes, size_t size);
+	void output(const Event* events, size_t count);
+	void pace();
+	void drainRateLimiter();
+	/// Writes events pumped from the rate limiter, with each MIDI_SYSEX placeholder
+	/// replaced by the next payload in \a sysex.
+	void outputPaced(const Event* events, size_t count, std::deque<std::vector<uint8_t>>& sysex);
+	
+
+	struct Scheduled
+	{
+		uint64_t time;
+		uint64_t sequence; ///< keeps events with the same time in order
+		Event event;
+		bool operator<(const Scheduled& other) const
+		{
+			// std::push_heap builds a max heap, so the earliest event compares greatest
+			return time != other.time ? time > other.time : sequence > other.sequence;
+		}
+	};
+	void dispatch();
+	/// Forgets the kernel scheduled events that are due by now, tracking their notes.
+	void retireKernelEvents(uint64_t now);
+	
+
 	std::string mName;
 	std::shared_ptr<RtMidiOut> mRtMidiOut;
 	bool mIsVirtual; ///< mIsVirtual => port is open as virtual port
 	std::string mPortName;
 	int mPortNumber; ///< mPortNumber == -1 => port is not open or is open as virtual port
 	// Invariant: mIsVirtual => mPortNumber == -1
-	/// Vector used to create midi messages. This should be kept at a length of 3
-	/// and may be wiped at any point by any function. It is used by sendMessage( , , )
-	std::vector<unsigned char> mBytes;
-	// Invariant: mBytes.size() == 3
+	bool mNoteTracking;
+	int mBatchDepth;
+	ActiveNotes mActiveNotes;
+	
+	std::vector<Scheduled> mSchedule; ///< binary heap, reserved by setScheduling()
+	std::vector<Scheduled> mKernelSchedule; ///< events handed to the ALSA queue and not due yet, heap as well
+	size_t mScheduleCapacity;
+	uint64_t mScheduleSequence;
+	bool mStopDispatcher;
+	mutable std::mutex mScheduleMutex;
+	std::condition_variable mScheduleCondition;
+	std::thread mDispatcher;
+	
+	std::unique_ptr<MpscRingBuffer<Queued>> mAsyncQueue;
+	uint32_t mBlockTimeoutMicros;
+	std::deque<std::vector<uint8_t>> mAsyncSysex;
+	std::mutex mSysexMutex;
+	std::mutex mDriverMutex; ///< held by the writer while it talks to the driver, and around open/close
+	std::mutex mWakeMutex;
+	std::condition_variable mWakeCondition;
+	std::atomic<bool> mWriterIdle;
+	std::atomic<bool> mStopWriter;
+	std::thread mWriter;
+	std::atomic<uint64_t> mOutputEnqueuedCount;
+	std::atomic<uint64_t> mOutputWrittenCount;
+	std::atomic<uint64_t> mOutputDroppedCount;
+	std::atomic<uint64_t> mOutputLagNanos;
+	std::atomic<uint64_t> mMaxOutputLagNanos;
+	
+	std::unique_ptr<RateLimiter> mRateLimiter;
+	std::deque<std::vector<uint8_t>> mPacedSysex; ///< payloads of the limiter's sysex placeholders
+	std::mutex mPaceMutex; ///< guards mRateLimiter's queues and mPacedSysex
+	std::condition_variable mPaceCondition;
+	bool mStopPacer;
+	std::thread mPacer;
 };
 
 }} // namespaces
@@ -0,0 +1,288 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+#include "MidiEvent.h"
+
+
+namespace cinder { namespace midi {
+
+	///
+	/// A high resolution parameter change assembled from several control changes.
+	///
+	struct ParameterEvent {
+		enum Kind : uint8_t {
+			CONTROLLER_14BIT,	//< MSB on controller 0 - 31 with its LSB on controller 32 - 63, id is the MSB controller
+			RPN,				//< registered parameter (CC 101/100 + data entry), id is the 14 bit parameter number
+			NRPN				//< non-registered parameter (CC 99/98 + data entry)
+		};
+
+		uint8_t		kind;
+		uint8_t		channel;	//< 1 - 16
+		uint8_t		port;
+		uint16_t	id;
+		uint16_t	value;		//< 0 - 16383
+		uint32_t	time;		//< same time base as Event::time
+	};
+
+	///
+	/// Tracks per-channel parameter number and MSB/LSB state on the midi thread
+	/// and turns CC MSB/LSB pairs and RPN/NRPN sequences into single ParameterEvents.
+	///
+	/// A controller that has never sent an LSB is reported on its MSB alone. Once an
+	/// LSB has been seen, the MSB is held until its LSB arrives; if it doesn't within
+	/// the LSB timeout the MSB is reported by itself on the next event, or by expire()
+	/// if traffic stops, and the controller is treated as 7 bit again. Data entry (CC 6/38) and increment /
+	/// decrement (CC 96/97) only count while an RPN or NRPN is selected.
+	///
+	/// Not thread safe; meant to be driven by the single midi thread.
+	///
+	class ParameterAssembler {
+	public:
+		explicit ParameterAssembler( uint32_t lsbTimeoutMicros = 10000 )
+			: mLsbTimeout( lsbTimeoutMicros )
+		{
+			reset();
+		}
+
+		void reset()
+		{
+			for( Channel &ch : mChannels )
+				ch = Channel();
+			mPendingChannels = 0;
+		}
+
+		///
+		/// Feeds one event. \a emit( const ParameterEvent& ) is called for every
+		/// parameter it completes.
+		/// \return true if the event was consumed as part of a parameter
+		///
+		template<typename EmitFn>
+		bool process( const Event &event, EmitFn &&emit )
+		{
+			mPort = event.port;
+			if( mPendingChannels )
+				expire( event.time, emit );
+
+			if( ( event.status & 0xF0 ) != MIDI_CONTROL_CHANGE )
+				return false;
+
+			const int index = event.status & 0x0F;
+			Channel &ch = mChannels[index];
+			const uint8_t cc = event.data1;
+			const uint8_t value = event.data2;
+
+			switch( cc ) {
+			case 99:	select( ch, ParameterEvent::NRPN, &ch.idMsb, value ); return true;
+			case 98:	select( ch, ParameterEvent::NRPN, &ch.idLsb, value ); return true;
+			case 101:	select( ch, ParameterEvent::RPN, &ch.idMsb, value ); return true;
+			case 100:	select( ch, ParameterEvent::RPN, &ch.idLsb, value ); return true;
+			case 6:
+				if( ch.kind == NONE )
+					return false;
+				flushData( ch, index, event, emit );
+				ch.dataMsb = value;
+				if( ch.dataHasLsb ) {
+					ch.dataPending = true;
+					ch.dataTime = event.time;
+					mPendingChannels |= uint16_t( 1 << index );
+				}
+				else {
+					ch.dataValue = uint16_t( value << 7 );
+					emitData( ch, index, event, emit );
+				}
+				return true;
+			case 38:
+				if( ch.kind == NONE )
+					return false;
+				ch.dataHasLsb = true;
+				ch.dataPending = false;
+				ch.dataValue = uint16_t( ( ch.dataMsb << 7 ) | value );
+				emitData( ch, index, event, emit );
+				return true;
+			case 96:
+			case 97:
+				if( ch.kind == NONE )
+					return false;
+				flushData( ch, index, event, emit );
+				if( cc == 96 && ch.dataValue < 16383 )
+					++ch.dataValue;
+				else if( cc == 97 && ch.dataValue > 0 )
+					--ch.dataValue;
+				ch.dataMsb = uint8_t( ch.dataValue >> 7 );
+				emitData( ch, index, event, emit );
+				return true;
+			default:
+				break;
+			}
+
+			if( cc < 32 ) {
+				const uint32_t bit = 1u << cc;
+				if( ch.pending & bit )
+					emitController( index, cc, uint16_t( ch.msb[cc] << 7 ), ch.pendingTime[cc], emit );
+				ch.msb[cc] = value;
+				if( ch.hasLsb & bit ) {
+					ch.pending |= bit;
+					ch.pendingTime[cc] = event.time;
+					mPendingChannels |= uint16_t( 1 << index );
+				}
+				else {
+					ch.pending &= ~bit;
+					emitController( index, cc, uint16_t( value << 7 ), event.time, emit );
+				}
+				return true;
+			}
+
+			if( cc < 64 ) {
+				const int msbCc = cc - 32;
+				const uint32_t bit = 1u << msbCc;
+				ch.hasLsb |= bit;
+				ch.pending &= ~bit;
+				emitController( index, msbCc, uint16_t( ( ch.msb[msbCc] << 7 ) | value ), event.time, emit );
+				return true;
+			}
+
+			return false;
+		}
+
+		/// true while an MSB waits for its LSB
+		bool hasPending() const		{ return mPendingChannels != 0; }
+
+		///
+		/// Reports every MSB whose LSB is overdue at \a now, eg. from a timer when no
+		/// further event may arrive to do it.
+		///
+		template<typename EmitFn>
+		void expire( uint32_t now, EmitFn &&emit )
+		{
+			uint16_t stillPending = 0;
+			for( int index = 0; index < 16; ++index ) {
+				if( !( ( mPendingChannels >> index ) & 1 ) )
+					continue;
+
+				Channel &ch = mChannels[index];
+				for( int cc = 0; cc < 32 && ch.pending; ++cc ) {
+					const uint32_t bit = 1u << cc;
+					if( !( ch.pending & bit ) || now - ch.pendingTime[cc] <= mLsbTimeout )
+						continue;
+					// the LSB never came: report the MSB alone and stop waiting for this controller
+					ch.pending &= ~bit;
+					ch.hasLsb &= ~bit;
+					emitController( index, cc, uint16_t( ch.msb[cc] << 7 ), ch.pendingTime[cc], emit );
+				}
+				if( ch.dataPending && now - ch.dataTime > mLsbTimeout ) {
+					ch.dataHasLsb = false;
+					Event stale( uint8_t( MIDI_CONTROL_CHANGE | index ), 6, ch.dataMsb, mPort, ch.dataTime );
+					flushData( ch, index, stale, emit );
+				}
+				if( ch.pending || ch.dataPending )
+					stillPending |= uint16_t( 1 << index );
+			}
+			mPendingChannels = stillPending;
+		}
+
+	private:
+		enum { NONE = 0xFF };
+
+		struct Channel {
+			uint8_t		msb[32] = {};
+			uint32_t	pendingTime[32] = {};
+			uint32_t	pending = 0;		//< MSBs waiting for their LSB
+			uint32_t	hasLsb = 0;			//< controllers that have sent an LSB before
+
+			uint8_t		kind = NONE;		//< selected ParameterEvent::Kind
+			uint8_t		idMsb = 0x7F;
+			uint8_t		idLsb = 0x7F;
+			uint8_t		dataMsb = 0;
+			uint16_t	dataValue = 0;
+			bool		dataPending = false;
+			bool		dataHasLsb = false;
+			uint32_t	dataTime = 0;
+		};
+
+		void select( Channel &ch, uint8_t kind, uint8_t *idByte, uint8_t value )
+		{
+			// a new parameter number resets the data entry state
+			if( ch.kind != kind ) {
+				ch.idMsb = ch.idLsb = 0x7F;
+				ch.kind = kind;
+			}
+			*idByte = value;
+			ch.dataPending = false;
+			ch.dataValue = 0;
+			// 127/127 is the null parameter, which deselects
+			if( ch.idMsb == 0x7F && ch.idLsb == 0x7F )
+				ch.kind = NONE;
+		}
+
+		template<typename EmitFn>
+		void emitController( int index, int cc, uint16_t value, uint32_t time, EmitFn &emit )
+		{
+			ParameterEvent p;
+			p.kind = ParameterEvent::CONTROLLER_14BIT;
+			p.channel = uint8_t( index + 1 );
+			p.port = mPort;
+			p.id = uint16_t( cc );
+			p.value = value;
+			p.time = time;
+			emit( p );
+		}
+
+		template<typename EmitFn>
+		void emitData( Channel &ch, int index, const Event &event, EmitFn &emit )
+		{
+			ParameterEvent p;
+			p.kind = ch.kind;
+			p.channel = uint8_t( index + 1 );
+			p.port = mPort;
+			p.id = uint16_t( ( ch.idMsb << 7 ) | ch.idLsb );
+			p.value = ch.dataValue;
+			p.time = event.time;
+			emit( p );
+		}
+
+		template<typename EmitFn>
+		void flushData( Channel &ch, int index, const Event &event, EmitFn &emit )
+		{
+			if( !ch.dataPending )
+				return;
+			ch.dataPending = false;
+			ch.dataValue = uint16_t( ch.dataMsb << 7 );
+			emitData( ch, index, event, emit );
+		}
+
+		uint32_t	mLsbTimeout;
+		Channel		mChannels[16];
+		uint16_t	mPendingChannels;
+		uint8_t		mPort { 0 };
+	};
+
+} // namespace midi
+} // namespace cinder
@@ -0,0 +1,105 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "RtMidi.h"
+
+
+namespace cinder { namespace midi {
+
+	struct PortInfo {
+		unsigned int	index;	//< port number for openPort() in the current enumeration
+		std::string		name;	//< as reported by the backend, eg. "Client:Port 20:0" on ALSA
+		/// Identifies the port while it exists, even if another device takes its index or
+		/// name: "client:port" on ALSA, the name elsewhere.
+		std::string		id;
+
+		bool operator==( const PortInfo &other ) const	{ return index == other.index && name == other.name && id == other.id; }
+		bool operator!=( const PortInfo &other ) const	{ return !( *this == other ); }
+	};
+
+	///
+	/// Shared snapshot of the system's midi ports.
+	///
+	/// Enumerating ports is expensive on some backends (ALSA walks every sequencer
+	/// client for each name), so inputs, outputs and the hub look ports up here
+	/// instead. The snapshot is taken once and only replaced when refresh() finds a
+	/// different set of ports. Names are indexed in a hash map.
+	/// All methods are thread safe.
+	///
+	class PortRegistry {
+	public:
+		static PortRegistry& get();
+
+		/// The first query enumerates the ports; after that, call refresh() to pick up changes.
+		/// Re-enumerates and replaces the snapshot if any port was added, removed or swapped
+		/// for another one, or always with \a force. Cheap enough to call every frame: only
+		/// the port counts are checked on each call, names at most once a second.
+		/// \return true if the snapshot changed
+		bool refresh( bool force = false );
+		/// Incremented every time the snapshot changes.
+		uint32_t getGeneration() const;
+
+		std::vector<PortInfo> getInputs();
+		std::vector<PortInfo> getOutputs();
+		/// \return the port number, or -1 if there is no such port
+		int findInput( const std::string &name );
+		int findOutput( const std::string &name );
+		/// \return "" if \a index is out of range
+		std::string getInputName( unsigned int index );
+		std::string getOutputName( unsigned int index );
+
+	private:
+		PortRegistry();
+
+		void enumerateLocked();
+		static void enumerate( RtMidi &api, RtMidi::Api backend, std::vector<PortInfo> &ports );
+		static void buildIndex( const std::vector<PortInfo> &ports, std::unordered_map<std::string, unsigned int> &index );
+		static std::string makeId( RtMidi::Api backend, const std::string &name );
+
+		mutable std::mutex								mMutex;
+		RtMidiIn										mIn;
+		RtMidiOut										mOut;
+		std::vector<PortInfo>							mInputs;
+		std::vector<PortInfo>							mOutputs;
+		std::unordered_map<std::string, unsigned int>	mInputIndex;
+		std::unordered_map<std::string, unsigned int>	mOutputIndex;
+		std::chrono::steady_clock::time_point			mLastCompare;	//< last full comparison of the port names
+		uint32_t										mGeneration;
+		bool											mEnumerated;
+	};
+
+} // namespace midi
+} // namespace cinder
@@ -0,0 +1,142 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "MidiEvent.h"
+
+
+namespace cinder { namespace midi {
+
+	///
+	/// Bandwidth budget for an output port, with controller thinning.
+	///
+	/// Controller, pitch bend and channel pressure updates go into last-value-wins
+	/// slots: a newer value replaces one that is still pending, and a value equal to
+	/// the last one sent is dropped. Everything else, notes and sysex included, goes
+	/// into a preallocated FIFO that is never thinned; when it is full new events are
+	/// dropped and counted. pump() hands out the FIFO first, then the pending slots
+	/// round-robin, as far as a token bucket refilled at the byte rate allows.
+	///
+	/// Controllers whose order against notes or each other matters (bank select, data
+	/// entry, RPN / NRPN, the pedals and channel mode messages) take the FIFO too.
+	///
+	/// Not thread safe, MidiOut guards it with a lock. The counters may be read from
+	/// any thread.
+	///
+	class RateLimiter {
+	public:
+		/// 31250 baud with a start and a stop bit per byte, ie. DIN MIDI.
+		static constexpr double kDinBytesPerSecond = 3125.0;
+
+		/// \a queueCapacity is the number of unthinned events, eg. notes, that may wait at once.
+		explicit RateLimiter( double bytesPerSecond = kDinBytesPerSecond, double burstBytes = 32.0, size_t queueCapacity = 1024 );
+
+		/// \a burstBytes is how much unused budget may pile up while the port is idle.
+		void setBudget( double bytesPerSecond, double burstBytes = 32.0 );
+		double getBytesPerSecond() const	{ return mBytesPerSecond; }
+
+		/// true for the controller, pitch bend and channel pressure updates that are thinned
+		static bool isThinnable( const Event &event );
+
+		/// Queues \a event for the next pump().
+		/// \return false if it was dropped as a repeat of the value last sent, or the FIFO is full
+		bool push( const Event &event );
+		/// Queues a MIDI_SYSEX placeholder of \a bytes in the FIFO. The caller keeps the
+		/// payload and sends it in place of the placeholder once pump() hands that out.
+		/// \return false if the FIFO is full
+		bool pushSysex( size_t bytes );
+		/// Writes up to \a max events that fit the budget at \a nowNanos into \a out.
+		/// \return the number of events written
+		size_t pump( uint64_t nowNanos, Event *out, size_t max );
+		/// As pump(), but ignores the budget, eg. to empty the limiter before closing the port.
+		size_t takeAll( Event *out, size_t max );
+		/// Nanoseconds until pump() has something to hand out, or UINT64_MAX if nothing is pending.
+		uint64_t getWaitNanos( uint64_t nowNanos ) const;
+
+		bool empty() const					{ return mQueueCount == 0 && mPendingCount == 0; }
+		/// Drops everything pending and forgets the values sent, eg. when the port changes.
+		void reset();
+		/// Controller updates replaced by a newer value before they were sent.
+		uint64_t getThinnedCount() const	{ return mThinnedCount.load( std::memory_order_relaxed ); }
+		/// Controller updates dropped because the value had been sent already.
+		uint64_t getSuppressedCount() const	{ return mSuppressedCount.load( std::memory_order_relaxed ); }
+		/// Unthinned events dropped because the FIFO was full.
+		uint64_t getDroppedCount() const	{ return mDroppedCount.load( std::memory_order_relaxed ); }
+		void resetStats();
+
+	private:
+		// 128 controllers, pitch bend and channel pressure per channel, as in Coalescer
+		static const int kSlotsPerChannel = 130;
+		static const int kSlotCount = 16 * kSlotsPerChannel;
+		static const int kWordCount = ( kSlotCount + 63 ) / 64;
+
+		struct Queued {
+			Event	event;
+			size_t	bytes;		//< charged against the budget, the payload size for sysex
+		};
+
+		struct Slot {
+			Event	pending;
+			Event	sent;
+			bool	hasSent;
+		};
+
+		static int slotIndex( const Event &event );
+		void refill( uint64_t nowNanos );
+		/// Next pending slot at or after the round-robin cursor, or -1.
+		int nextPending() const;
+		void clearPending( int index );
+		bool enqueue( const Event &event, size_t bytes );
+		const Queued& front() const			{ return mQueue[mQueueHead]; }
+		void popFront();
+
+		double					mBytesPerSecond;
+		double					mBurstBytes;
+		double					mTokens;
+		uint64_t				mLastRefill;
+
+		std::unique_ptr<Queued[]>	mQueue;
+		size_t					mQueueCapacity;
+		size_t					mQueueHead;
+		size_t					mQueueCount;
+		Slot					mSlots[kSlotCount];
+		uint64_t				mPendingBits[kWordCount];
+		size_t					mPendingCount;
+		int						mCursor;
+
+		std::atomic<uint64_t>	mThinnedCount;
+		std::atomic<uint64_t>	mSuppressedCount;
+		std::atomic<uint64_t>	mDroppedCount;
+	};
+
+} // namespace midi
+} // namespace cinder
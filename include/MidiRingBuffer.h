@@ -0,0 +1,215 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+namespace cinder { namespace midi {
+
+	///
+	/// Fixed capacity, lock-free single producer / single consumer ring.
+	///
+	/// Storage is allocated once in the constructor; push() and pop() never
+	/// allocate or lock, so the producer side is safe to call from the midi
+	/// thread. Capacity is rounded up to the next power of two.
+	///
+	template<typename T>
+	class RingBuffer {
+	public:
+		explicit RingBuffer( size_t capacity )
+			: mCapacity( roundUpPow2( capacity ) ), mMask( mCapacity - 1 ), mSlots( mCapacity ), mHead( 0 ), mTail( 0 )
+		{}
+
+		RingBuffer( const RingBuffer& ) = delete;
+		RingBuffer& operator=( const RingBuffer& ) = delete;
+
+		/// Producer side. \return false if the ring is full.
+		bool push( const T& value )
+		{
+			const size_t head = mHead.load( std::memory_order_relaxed );
+			if( head - mTail.load( std::memory_order_acquire ) == mCapacity )
+				return false;
+			mSlots[head & mMask] = value;
+			mHead.store( head + 1, std::memory_order_release );
+			return true;
+		}
+
+		/// Consumer side. \return false if the ring is empty.
+		bool pop( T& value )
+		{
+			const size_t tail = mTail.load( std::memory_order_relaxed );
+			if( tail == mHead.load( std::memory_order_acquire ) )
+				return false;
+			value = mSlots[tail & mMask];
+			mTail.store( tail + 1, std::memory_order_release );
+			return true;
+		}
+
+		/// Consumer side. Pops up to \a max values into \a out.
+		/// \return the number of values written
+		size_t pop( T* out, size_t max )
+		{
+			const size_t tail = mTail.load( std::memory_order_relaxed );
+			size_t count = mHead.load( std::memory_order_acquire ) - tail;
+			if( count > max )
+				count = max;
+			for( size_t i = 0; i < count; ++i )
+				out[i] = mSlots[( tail + i ) & mMask];
+			mTail.store( tail + count, std::memory_order_release );
+			return count;
+		}
+
+		/// Approximate when called concurrently with push() or pop(). The tail is loaded
+		/// first so a third thread can't see it past the head; the clamp covers both
+		/// ends moving on between the two loads.
+		size_t size() const
+		{
+			const size_t tail = mTail.load( std::memory_order_acquire );
+			const size_t head = mHead.load( std::memory_order_acquire );
+			return head > tail ? std::min( head - tail, mCapacity ) : 0;
+		}
+		bool empty() const		{ return size() == 0; }
+		size_t capacity() const	{ return mCapacity; }
+
+	private:
+		static size_t roundUpPow2( size_t v )
+		{
+			size_t p = 1;
+			while( p < v )
+				p <<= 1;
+			return p;
+		}
+
+		const size_t		mCapacity;
+		const size_t		mMask;
+		std::vector<T>		mSlots;
+		// head and tail are padded onto separate cache lines so producer and consumer don't false-share
+		char				mPad0[64];
+		std::atomic<size_t>	mHead;
+		char				mPad1[64];
+		std::atomic<size_t>	mTail;
+	};
+
+	///
+	/// Fixed capacity, lock-free multiple producer / single consumer ring.
+	///
+	/// Each slot carries a sequence number, so producers claim a slot with a single
+	/// compare-and-swap and publish it independently of each other. As with RingBuffer,
+	/// storage is allocated once and capacity is rounded up to the next power of two.
+	///
+	template<typename T>
+	class MpscRingBuffer {
+	public:
+		explicit MpscRingBuffer( size_t capacity )
+			: mCapacity( roundUpPow2( capacity ) ), mMask( mCapacity - 1 ), mCells( new Cell[mCapacity] ), mHead( 0 ), mTail( 0 )
+		{
+			for( size_t i = 0; i < mCapacity; ++i )
+				mCells[i].sequence.store( i, std::memory_order_relaxed );
+		}
+
+		MpscRingBuffer( const MpscRingBuffer& ) = delete;
+		MpscRingBuffer& operator=( const MpscRingBuffer& ) = delete;
+
+		/// Producer side, any thread. \return false if the ring is full.
+		bool push( const T& value )
+		{
+			size_t head = mHead.load( std::memory_order_relaxed );
+			Cell *cell;
+			for( ;; ) {
+				cell = &mCells[head & mMask];
+				const size_t sequence = cell->sequence.load( std::memory_order_acquire );
+				const std::ptrdiff_t diff = (std::ptrdiff_t)sequence - (std::ptrdiff_t)head;
+				if( diff == 0 ) {
+					if( mHead.compare_exchange_weak( head, head + 1, std::memory_order_relaxed ) )
+						break;
+				}
+				else if( diff < 0 )
+					return false;
+				else
+					head = mHead.load( std::memory_order_relaxed );
+			}
+			cell->value = value;
+			cell->sequence.store( head + 1, std::memory_order_release );
+			return true;
+		}
+
+		/// Consumer side. \return false if the ring is empty, or the oldest slot is claimed
+		/// but not yet published.
+		bool pop( T& value )
+		{
+			const size_t tail = mTail.load( std::memory_order_relaxed );
+			Cell &cell = mCells[tail & mMask];
+			if( cell.sequence.load( std::memory_order_acquire ) != tail + 1 )
+				return false;
+			value = cell.value;
+			cell.sequence.store( tail + mCapacity, std::memory_order_release );
+			mTail.store( tail + 1, std::memory_order_release );
+			return true;
+		}
+
+		/// Approximate when called concurrently with push() or pop(). The tail is loaded
+		/// first, so a consumer running ahead between the two loads can't underflow it.
+		size_t size() const
+		{
+			const size_t tail = mTail.load( std::memory_order_acquire );
+			const size_t head = mHead.load( std::memory_order_acquire );
+			return head > tail ? head - tail : 0;
+		}
+		bool empty() const		{ return size() == 0; }
+		size_t capacity() const	{ return mCapacity; }
+
+	private:
+		struct Cell {
+			std::atomic<size_t>	sequence;
+			T					value;
+		};
+
+		static size_t roundUpPow2( size_t v )
+		{
+			size_t p = 1;
+			while( p < v )
+				p <<= 1;
+			return p;
+		}
+
+		const size_t				mCapacity;
+		const size_t				mMask;
+		std::unique_ptr<Cell[]>		mCells;
+		char						mPad0[64];
+		std::atomic<size_t>			mHead;
+		char						mPad1[64];
+		std::atomic<size_t>			mTail;
+	};
+
+} // namespace midi
+} // namespace cinder
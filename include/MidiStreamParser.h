@@ -0,0 +1,182 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "MidiDecoder.h"
+
+
+namespace cinder { namespace midi {
+
+	///
+	/// Incremental parser for raw midi byte streams, eg. serial adapters, captured
+	/// dumps or network payloads, which may be cut at any byte.
+	///
+	/// Handles running status, realtime bytes interleaved anywhere (including inside
+	/// sysex) and sysex fragmented over several chunks, following the status rules
+	/// of the status table in MidiDecoder.h. Channel and system messages are
+	/// emitted as Events without allocating; sysex is gathered into a buffer
+	/// reserved once in the constructor.
+	///
+	class StreamParser {
+	public:
+		/// Sysex longer than \a maxSysexSize bytes is dropped and counted.
+		explicit StreamParser( size_t maxSysexSize = 4096, uint8_t port = 0 )
+			: mMaxSysexSize( maxSysexSize ), mPort( port )
+		{
+			mSysex.reserve( maxSysexSize );
+			reset();
+		}
+
+		/// Forgets running status and any partial message.
+		void reset()
+		{
+			mStatus = 0;
+			mExpected = 0;
+			mCount = 0;
+			mInSysex = false;
+			mSysexOverflow = false;
+			mSysex.clear();
+		}
+
+		///
+		/// Feeds \a length bytes. \a onEvent( const Event& ) is called for every complete
+		/// message, \a onSysex( const uint8_t *bytes, size_t length ) for every complete
+		/// sysex, including its MIDI_SYSEX and MIDI_SYSEX_END bytes. Events are stamped
+		/// with \a time.
+		///
+		/// Only takes part in overload resolution when \a onSysex is callable that way, so
+		/// parse( data, n, onEvent, time ) picks the overload below.
+		///
+		template<typename EventFn, typename SysexFn,
+			typename = decltype( std::declval<SysexFn&>()( std::declval<const uint8_t*>(), std::declval<size_t>() ) )>
+		void parse( const uint8_t *data, size_t length, EventFn &&onEvent, SysexFn &&onSysex, uint32_t time = 0 )
+		{
+			for( size_t i = 0; i < length; ++i ) {
+				const uint8_t byte = data[i];
+
+				if( byte < 0x80 ) {
+					if( mInSysex ) {
+						if( mSysex.size() < mMaxSysexSize )
+							mSysex.push_back( byte );
+						else
+							mSysexOverflow = true;
+					}
+					else if( mStatus ) {
+						mData[mCount++] = byte;
+						if( mCount == mExpected ) {
+							onEvent( Event( mStatus, mData[0], mExpected > 1 ? mData[1] : 0, mPort, time ) );
+							mCount = 0;
+							// only channel messages may run on
+							if( mStatus >= MIDI_SYSEX )
+								mStatus = 0;
+						}
+					}
+					// stray data bytes without a status are ignored
+					continue;
+				}
+
+				const StatusInfo &info = getStatusInfo( byte );
+
+				// realtime bytes don't disturb whatever they interrupt
+				if( info.isRealtime() ) {
+					onEvent( Event( byte, 0, 0, mPort, time ) );
+					continue;
+				}
+
+				if( byte == MIDI_SYSEX_END ) {
+					if( mInSysex ) {
+						mInSysex = false;
+						if( !mSysexOverflow && mSysex.size() < mMaxSysexSize ) {
+							mSysex.push_back( byte );
+							onSysex( mSysex.data(), mSysex.size() );
+						}
+						else {
+							++mSysexDropped;
+						}
+					}
+					continue;
+				}
+
+				// any other status ends an unterminated sysex
+				if( mInSysex ) {
+					mInSysex = false;
+					++mSysexDropped;
+				}
+
+				mCount = 0;
+				if( info.isSysex() ) {
+					mStatus = 0;
+					mInSysex = true;
+					mSysexOverflow = false;
+					mSysex.clear();
+					mSysex.push_back( byte );
+				}
+				else if( info.length == 1 ) {
+					// tune request and undefined system common: complete already, and they cancel running status
+					mStatus = 0;
+					onEvent( Event( byte, 0, 0, mPort, time ) );
+				}
+				else {
+					mStatus = byte;
+					mExpected = info.length - 1;
+				}
+			}
+		}
+
+		/// As above, dropping sysex.
+		template<typename EventFn>
+		void parse( const uint8_t *data, size_t length, EventFn &&onEvent, uint32_t time = 0 )
+		{
+			parse( data, length, onEvent, []( const uint8_t *, size_t ) {}, time );
+		}
+
+		/// Number of sysex messages dropped because they were too long or unterminated.
+		uint64_t getSysexDroppedCount() const	{ return mSysexDropped; }
+
+	private:
+		size_t					mMaxSysexSize;
+		uint8_t					mPort;
+
+		uint8_t					mStatus;	//< running status, 0 if none
+		uint8_t					mExpected;	//< data bytes per message for mStatus
+		uint8_t					mCount;
+		uint8_t					mData[2];
+
+		bool					mInSysex;
+		bool					mSysexOverflow;
+		std::vector<uint8_t>	mSysex;
+		uint64_t				mSysexDropped { 0 };
+	};
+
+} // namespace midi
+} // namespace cinder
@@ -0,0 +1,89 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "MidiEvent.h"
+
+
+namespace cinder { namespace midi {
+
+	///
+	/// Recycled slab of sysex buffers.
+	///
+	/// The midi thread copies each sysex payload into a free slot and the event only
+	/// carries the slot's handle (see Event::getSysexHandle()). Slots are reference
+	/// counted: every queue that holds the event keeps a reference and releases it
+	/// once delivered, after which the slot is reused. Slot buffers are allocated up
+	/// front and only grow when a dump is larger than anything seen before, so
+	/// steady state traffic never allocates on the midi thread.
+	///
+	class SysexPool {
+	public:
+		static const int INVALID_HANDLE = -1;
+		static const size_t MAX_SLOTS = 1 << 14;	//< handles have to fit in the two data bytes
+
+		SysexPool( size_t slotCount = 16, size_t slotSize = 4096 );
+
+		/// Producer side. Copies \a size bytes into a free slot holding one reference.
+		/// \return the slot's handle, or INVALID_HANDLE if every slot is in use
+		int store( const uint8_t *data, size_t size );
+
+		void retain( int handle );
+		/// Releases one reference. Releasing a slot nobody holds is ignored (and asserts in debug).
+		void release( int handle );
+
+		const uint8_t*	getData( int handle ) const;
+		size_t			getSize( int handle ) const;
+
+		size_t		getSlotCount() const		{ return mSlotCount; }
+		/// Number of sysex messages dropped because the pool was exhausted.
+		uint64_t	getDroppedCount() const		{ return mDroppedCount.load( std::memory_order_relaxed ); }
+
+	private:
+		struct Slot {
+			std::vector<uint8_t>	bytes;
+			size_t					size { 0 };
+			std::atomic<int>		refs { 0 };
+		};
+
+		bool isValid( int handle ) const	{ return handle >= 0 && (size_t) handle < mSlotCount; }
+
+		size_t					mSlotCount;
+		std::unique_ptr<Slot[]>	mSlots;
+		size_t					mNextSlot { 0 };	//< producer only
+		std::atomic<uint64_t>	mDroppedCount { 0 };
+	};
+
+} // namespace midi
+} // namespace cinder
@@ -0,0 +1,117 @@
+/*
+MidiBlock for Cinder developed by Bruce Lane, Martin Blasko. 
+Original code by Hector Sanchez-Pajares(http://www.aerstudio.com).
+MidiOut written by Tim Murray-Browne (http://timmb.com)
+Midi parsing taken from openFrameworks addon ofxMidi by Theo Watson & Dan Wilcox
+
+
+This is a block for MIDI Integration for Cinder framework developed by The Barbarian Group, 2010
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+
+* Redistributions of source code must retain the above copyright notice, this list of conditions and
+the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright notice, this list of conditions and
+the following disclaimer in the documentation and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "MidiEvent.h"
+
+
+namespace cinder { namespace midi {
+
+	enum TimecodeRate {
+		MTC_24_FPS			= 0,
+		MTC_25_FPS			= 1,
+		MTC_29_97_FPS_DROP	= 2,
+		MTC_30_FPS			= 3
+	};
+
+	/// Consistent copy of the timecode follower, see TimecodeTracker::read().
+	struct Timecode {
+		bool			valid;		//< false until a full frame message or eight quarter frames arrived
+		TimecodeRate	rate;
+		uint8_t			hours;
+		uint8_t			minutes;
+		uint8_t			seconds;
+		uint8_t			frames;
+		uint32_t		quarterFrames;	//< position in quarter frames since 00:00:00:00, drop frames skipped
+		uint32_t		time;			//< Event::time at which quarterFrames was current
+		bool			running;		//< quarter frames were coming in as of \a time, see isRunning()
+
+		/// A master that stops just stops sending quarter frames, so after this long without
+		/// one the timecode counts as stopped. About ten quarter frames at 24 fps.
+		static const uint32_t TIMEOUT = 100000;
+
+		double getFps() const;
+		/// true while quarter frames are still arriving at \a now, in Event::time units.
+		bool isRunning( uint32_t now ) const	{ return running && (int32_t) ( now - time ) < (int32_t) TIMEOUT; }
+		/// Position in seconds at \a now, in Event::time units. While running it is interpolated
+		/// up to the next quarter frame and never beyond, so it keeps advancing monotonically.
+		double getSeconds( uint32_t now ) const;
+
+		/// Frame count since 00:00:00:00 for a timecode label, and back, handling drop frames.
+		static uint32_t toFrameNumber( int hours, int minutes, int seconds, int frames, TimecodeRate rate );
+		static void fromFrameNumber( uint32_t frameNumber, TimecodeRate rate, uint8_t *hours, uint8_t *minutes, uint8_t *seconds, uint8_t *frames );
+	};
+
+	///
+	/// Follows MIDI time code on the midi thread.
+	///
+	/// Quarter frames (MIDI_TIME_CODE) are assembled into a full timecode every eight
+	/// messages and advance the position by a quarter frame in between; full frame
+	/// sysex messages locate directly. The frame rate is taken from the messages.
+	/// The position is published behind a sequence lock; read() is lock-free from any thread.
+	///
+	class TimecodeTracker {
+	public:
+		TimecodeTracker();
+
+		/// Midi thread. \return true if \a event was a quarter frame
+		bool process( const Event &event );
+		/// Midi thread. \return true if \a data was a full frame message
+		bool processSysex( const uint8_t *data, size_t size, uint32_t time );
+		void reset();
+
+		/// Any thread.
+		void read( Timecode &timecode ) const;
+		/// As above, with \a running cleared once quarter frames stopped before \a now.
+		void read( Timecode &timecode, uint32_t now ) const;
+
+	private:
+		void onQuarterFrame( uint8_t data, uint32_t time );
+		void publish( uint32_t time );
+
+		// midi thread only
+		uint8_t			mPieces[8];
+		int				mNextPiece;		//< -1 until a sequence starts with piece 0
+		bool			mValid;
+		bool			mRunning;
+		TimecodeRate	mRate;
+		uint32_t		mQuarterFrames;
+		uint32_t		mLastQuarterFrame;	//< Event::time of the last quarter frame
+
+		std::atomic<uint32_t>	mSequence;
+		std::atomic<uint32_t>	mStateQuarterFrames;
+		std::atomic<uint32_t>	mStateTime;
+		std::atomic<uint8_t>	mStateFlags;	//< valid, running and the rate
+	};
+
+} // namespace midi
+} // namespace cinder
@@ -38,6 +38,7 @@
 
 #include "RtMidi.h"
 #include <sstream>
+#include <cstring>
 
 #if defined(__MACOSX_CORE__)
   #if TARGET_OS_IPHONE
@@ -453,6 +454,8 @@ static void midiInputCallback( const MIDIPacketList *list, void *procRef, void *
     if ( apiData->lastTime == 0 ) { // this happens when receiving asynchronous sysex messages
       apiData->lastTime = AudioGetCurrentHostTime();
     }
+    // host time counts mach_absolute_time(), the base of steady_clock on macOS
+    data->driverNanos = packet->timeStamp ? AudioConvertHostTimeToNanos( packet->timeStamp ) : 0;
     //std::cout << "TimeStamp = " << packet->timeStamp << std::endl;
 
     iByte = 0;
@@ -1010,11 +1013,11 @@ void MidiOutCore :: openVirtualPort( std::string portName )
   data->endpoint = endpoint;
 }
 
-void MidiOutCore :: sendMessage( std::vector<unsigned char> *message )
+void MidiOutCore :: sendMessage( const unsigned char *message, size_t size )
 {
   // We use the MIDISendSysex() function to asynchronously send sysex
   // messages.  Otherwise, we use a single CoreMidi MIDIPacket.
-  unsigned int nBytes = message->size();
+  unsigned int nBytes = static_cast<unsigned int>( size );
   if ( nBytes == 0 ) {
     errorString_ = "MidiOutCore::sendMessage: no data in message argument!";      
     error( RtMidiError::WARNING, errorString_ );
@@ -1025,7 +1028,7 @@ void MidiOutCore :: sendMessage( std::vector<unsigned char> *message )
   CoreMidiData *data = static_cast<CoreMidiData *> (apiData_);
   OSStatus result;
 
-  if ( message->at(0) != 0xF0 && nBytes > 3 ) {
+  if ( message[0] != 0xF0 && nBytes > 3 ) {
     errorString_ = "MidiOutCore::sendMessage: message format problem ... not sysex but > 3 bytes?";
     error( RtMidiError::WARNING, errorString_ );
     return;
@@ -1039,7 +1042,7 @@ void MidiOutCore :: sendMessage( std::vector<unsigned char> *message )
   ByteCount remainingBytes = nBytes;
   while (remainingBytes && packet) {
     ByteCount bytesForPacket = remainingBytes > 65535 ? 65535 : remainingBytes; // 65535 = maximum size of a MIDIPacket
-    const Byte* dataStartPtr = (const Byte *) &message->at( nBytes - remainingBytes );
+    const Byte* dataStartPtr = (const Byte *) &message[nBytes - remainingBytes];
     packet = MIDIPacketListAdd( packetList, listSize, packet, timeStamp, bytesForPacket, dataStartPtr);
     remainingBytes -= bytesForPacket; 
   }
@@ -1093,6 +1096,8 @@ void MidiOutCore :: sendMessage( std::vector<unsigned char> *message )
 
 #include <pthread.h>
 #include <sys/time.h>
+#include <errno.h>
+#include <chrono>
 
 // ALSA header file.
 #include <alsa/asoundlib.h>
@@ -1106,12 +1111,13 @@ struct AlsaMidiData {
   snd_seq_port_subscribe_t *subscription;
   snd_midi_event_t *coder;
   unsigned int bufferSize;
-  unsigned char *buffer;
   pthread_t thread;
   pthread_t dummy_thread_id;
   unsigned long long lastTime;
   int queue_id; // an input queue is needed to get timestamped events
   int trigger_fds[2];
+  bool batching; // output: drain once in flushBatch() instead of after every message
+  long long queueOrigin; // steady clock nanoseconds at queue time zero
 };
 
 #define PORT_TYPE( pinfo, bits ) ((snd_seq_port_info_get_capability(pinfo) & (bits)) == (bits))
@@ -1121,6 +1127,17 @@ struct AlsaMidiData {
 //  Class Definitions: MidiInAlsa
 //*********************************************************************//
 
+// Steady clock nanoseconds at time zero of a running queue, so queue timestamps can be mapped onto it.
+static long long alsaQueueOrigin( snd_seq_t *seq, int queue )
+{
+  snd_seq_queue_status_t *status;
+  snd_seq_queue_status_alloca( &status );
+  snd_seq_get_queue_status( seq, queue, status );
+  const snd_seq_real_time_t *now = snd_seq_queue_status_get_real_time( status );
+  long long steadyNow = std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+  return steadyNow - ( (long long) now->tv_sec * 1000000000LL + now->tv_nsec );
+}
+
 static void *alsaMidiHandler( void *ptr )
 {
   MidiInApi::RtMidiInData *data = static_cast<MidiInApi::RtMidiInData *> (ptr);
@@ -1270,6 +1287,9 @@ static void *alsaMidiHandler( void *ptr )
           // Method 2: Use the ALSA sequencer event time data.
           // (thanks to Pedro Lopez-Cabanillas!).
           time = ( ev->time.time.tv_sec * 1000000 ) + ( ev->time.time.tv_nsec/1000 );
+#ifndef AVOID_TIMESTAMPING
+          data->driverNanos = apiData->queueOrigin + (long long) ev->time.time.tv_sec * 1000000000LL + ev->time.time.tv_nsec;
+#endif
           lastTime = time;
           time -= apiData->lastTime;
           apiData->lastTime = lastTime;
@@ -1378,6 +1398,7 @@ void MidiInAlsa :: initialize( const std::string& clientName )
   }
 
   // Create the input queue
+  data->queueOrigin = 0;
 #ifndef AVOID_TIMESTAMPING
   data->queue_id = snd_seq_alloc_named_queue(seq, "RtMidi Queue");
   // Set arbitrary tempo (mm=100) and resolution (240)
@@ -1542,6 +1563,7 @@ void MidiInAlsa :: openPort( unsigned int portNumber, const std::string portName
 #ifndef AVOID_TIMESTAMPING
     snd_seq_start_queue( data->seq, data->queue_id, NULL );
     snd_seq_drain_output( data->seq );
+    data->queueOrigin = alsaQueueOrigin( data->seq, data->queue_id );
 #endif
     // Start our MIDI input thread.
     pthread_attr_t attr;
@@ -1604,6 +1626,7 @@ void MidiInAlsa :: openVirtualPort( std::string portName )
 #ifndef AVOID_TIMESTAMPING
     snd_seq_start_queue( data->seq, data->queue_id, NULL );
     snd_seq_drain_output( data->seq );
+    data->queueOrigin = alsaQueueOrigin( data->seq, data->queue_id );
 #endif
     // Start our MIDI input thread.
     pthread_attr_t attr;
@@ -1675,7 +1698,6 @@ MidiOutAlsa :: ~MidiOutAlsa()
   AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
   if ( data->vport >= 0 ) snd_seq_delete_port( data->seq, data->vport );
   if ( data->coder ) snd_midi_event_free( data->coder );
-  if ( data->buffer ) free( data->buffer );
   snd_seq_close( data->seq );
   delete data;
 }
@@ -1701,7 +1723,9 @@ void MidiOutAlsa :: initialize( const std::string& clientName )
   data->vport = -1;
   data->bufferSize = 32;
   data->coder = 0;
-  data->buffer = 0;
+  data->batching = false;
+  data->queue_id = -1;
+  data->queueOrigin = 0;
   int result = snd_midi_event_new( data->bufferSize, &data->coder );
   if ( result < 0 ) {
     delete data;
@@ -1709,13 +1733,6 @@ void MidiOutAlsa :: initialize( const std::string& clientName )
     error( RtMidiError::DRIVER_ERROR, errorString_ );
     return;
   }
-  data->buffer = (unsigned char *) malloc( data->bufferSize );
-  if ( data->buffer == NULL ) {
-    delete data;
-    errorString_ = "MidiOutAlsa::initialize: error allocating buffer memory!\n\n";
-    error( RtMidiError::MEMORY_ERROR, errorString_ );
-    return;
-  }
   snd_midi_event_init( data->coder );
   apiData_ = (void *) data;
 }
@@ -1824,6 +1841,7 @@ void MidiOutAlsa :: openPort( unsigned int portNumber, const std::string portNam
 
 void MidiOutAlsa :: closePort( void )
 {
+  cancelScheduled();
   if ( connected_ ) {
     AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
     snd_seq_unsubscribe_port( data->seq, data->subscription );
@@ -1847,25 +1865,67 @@ void MidiOutAlsa :: openVirtualPort( std::string portName )
   }
 }
 
-void MidiOutAlsa :: sendMessage( std::vector<unsigned char> *message )
+void MidiOutAlsa :: sendMessage( const unsigned char *message, size_t size )
+{
+  output( message, size, -1 );
+}
+
+bool MidiOutAlsa :: sendMessageAt( const unsigned char *message, size_t size, unsigned long long steadyNanos )
+{
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+  if ( data->queue_id < 0 ) {
+    // our own real-time queue, started once and mapped onto the steady clock
+    int queue = snd_seq_alloc_named_queue( data->seq, "RtMidi output queue" );
+    if ( queue < 0 ) {
+      errorString_ = "MidiOutAlsa::sendMessageAt: error allocating ALSA queue.";
+      error( RtMidiError::WARNING, errorString_ );
+      return false;
+    }
+    snd_seq_start_queue( data->seq, queue, NULL );
+    snd_seq_drain_output( data->seq );
+    data->queueOrigin = alsaQueueOrigin( data->seq, queue );
+    data->queue_id = queue;
+  }
+
+  long long queueNanos = (long long) steadyNanos - data->queueOrigin;
+  // already due: the queue delivers anything scheduled in its past right away
+  return output( message, size, queueNanos < 0 ? 0 : queueNanos );
+}
+
+void MidiOutAlsa :: cancelScheduled( void )
+{
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+  if ( data->queue_id < 0 ) return;
+
+  // hand over whatever is still buffered client side first, direct events included,
+  // then take our scheduled events back out of the kernel's pool
+  snd_seq_drain_output( data->seq );
+  snd_seq_remove_events_t *remove;
+  snd_seq_remove_events_alloca( &remove );
+  snd_seq_remove_events_set_condition( remove, SND_SEQ_REMOVE_OUTPUT );
+  snd_seq_remove_events_set_queue( remove, data->queue_id );
+  snd_seq_remove_events( data->seq, remove );
+  snd_seq_drop_output( data->seq );
+
+  // freeing the queue discards anything left on it; sendMessageAt() allocates a new one
+  snd_seq_free_queue( data->seq, data->queue_id );
+  data->queue_id = -1;
+  data->queueOrigin = 0;
+}
+
+bool MidiOutAlsa :: output( const unsigned char *message, size_t size, long long queueNanos )
 {
   int result;
   AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
-  unsigned int nBytes = message->size();
+  unsigned int nBytes = static_cast<unsigned int>( size );
   if ( nBytes > data->bufferSize ) {
+    // only sysex outgrows the encoder, the buffer is kept for the next one
     data->bufferSize = nBytes;
     result = snd_midi_event_resize_buffer ( data->coder, nBytes);
     if ( result != 0 ) {
       errorString_ = "MidiOutAlsa::sendMessage: ALSA error resizing MIDI event buffer.";
       error( RtMidiError::DRIVER_ERROR, errorString_ );
-      return;
-    }
-    free (data->buffer);
-    data->buffer = (unsigned char *) malloc( data->bufferSize );
-    if ( data->buffer == NULL ) {
-    errorString_ = "MidiOutAlsa::initialize: error allocating buffer memory!\n\n";
-    error( RtMidiError::MEMORY_ERROR, errorString_ );
-    return;
+      return false;
     }
   }
 
@@ -1873,22 +1933,49 @@ void MidiOutAlsa :: sendMessage( std::vector<unsigned char> *message )
   snd_seq_ev_clear(&ev);
   snd_seq_ev_set_source(&ev, data->vport);
   snd_seq_ev_set_subs(&ev);
-  snd_seq_ev_set_direct(&ev);
-  for ( unsigned int i=0; i<nBytes; ++i ) data->buffer[i] = message->at(i);
-  result = snd_midi_event_encode( data->coder, data->buffer, (long)nBytes, &ev );
+  if ( queueNanos < 0 )
+    snd_seq_ev_set_direct(&ev);
+  else {
+    snd_seq_real_time_t time;
+    time.tv_sec = (unsigned int) ( queueNanos / 1000000000LL );
+    time.tv_nsec = (unsigned int) ( queueNanos % 1000000000LL );
+    snd_seq_ev_schedule_real(&ev, data->queue_id, 0, &time);
+  }
+  // encoded straight from the caller's bytes
+  result = snd_midi_event_encode( data->coder, message, (long)nBytes, &ev );
   if ( result < (int)nBytes ) {
     errorString_ = "MidiOutAlsa::sendMessage: event parsing error!";
     error( RtMidiError::WARNING, errorString_ );
-    return;
+    return false;
   }
 
   // Send the event.
   result = snd_seq_event_output(data->seq, &ev);
+  if ( result == -EAGAIN ) {
+    // the client's output buffer is full (non-blocking mode), make room and retry
+    snd_seq_drain_output(data->seq);
+    result = snd_seq_event_output(data->seq, &ev);
+  }
   if ( result < 0 ) {
     errorString_ = "MidiOutAlsa::sendMessage: error sending MIDI message to port.";
     error( RtMidiError::WARNING, errorString_ );
-    return;
+    return false;
   }
+  if ( !data->batching )
+    snd_seq_drain_output(data->seq);
+  return true;
+}
+
+void MidiOutAlsa :: beginBatch()
+{
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+  data->batching = true;
+}
+
+void MidiOutAlsa :: flushBatch()
+{
+  AlsaMidiData *data = static_cast<AlsaMidiData *> (apiData_);
+  data->batching = false;
   snd_seq_drain_output(data->seq);
 }
 
@@ -2344,11 +2431,11 @@ void MidiOutWinMM :: openVirtualPort( std::string /*portName*/ )
   error( RtMidiError::WARNING, errorString_ );
 }
 
-void MidiOutWinMM :: sendMessage( std::vector<unsigned char> *message )
+void MidiOutWinMM :: sendMessage( const unsigned char *message, size_t size )
 {
   if ( !connected_ ) return;
 
-  unsigned int nBytes = static_cast<unsigned int>(message->size());
+  unsigned int nBytes = static_cast<unsigned int>( size );
   if ( nBytes == 0 ) {
     errorString_ = "MidiOutWinMM::sendMessage: message argument is empty!";
     error( RtMidiError::WARNING, errorString_ );
@@ -2357,7 +2444,7 @@ void MidiOutWinMM :: sendMessage( std::vector<unsigned char> *message )
 
   MMRESULT result;
   WinMidiData *data = static_cast<WinMidiData *> (apiData_);
-  if ( message->at(0) == 0xF0 ) { // Sysex message
+  if ( message[0] == 0xF0 ) { // Sysex message
 
     // Allocate buffer for sysex data.
     char *buffer = (char *) malloc( nBytes );
@@ -2368,7 +2455,7 @@ void MidiOutWinMM :: sendMessage( std::vector<unsigned char> *message )
     }
 
     // Copy data to buffer.
-    for ( unsigned int i=0; i<nBytes; ++i ) buffer[i] = message->at(i);
+    memcpy( buffer, message, nBytes );
 
     // Create and prepare MIDIHDR structure.
     MIDIHDR sysex;
@@ -2406,12 +2493,8 @@ void MidiOutWinMM :: sendMessage( std::vector<unsigned char> *message )
     }
 
     // Pack MIDI bytes into double word.
-    DWORD packet;
-    unsigned char *ptr = (unsigned char *) &packet;
-    for ( unsigned int i=0; i<nBytes; ++i ) {
-      *ptr = message->at(i);
-      ++ptr;
-    }
+    DWORD packet = 0;
+    memcpy( &packet, message, nBytes );
 
     // Send the message immediately.
     result = midiOutShortMsg( data->outHandle, packet );
@@ -2828,14 +2911,13 @@ void MidiOutJack :: closePort()
   data->port = NULL;
 }
 
-void MidiOutJack :: sendMessage( std::vector<unsigned char> *message )
+void MidiOutJack :: sendMessage( const unsigned char *message, size_t size )
 {
-  int nBytes = message->size();
+  int nBytes = static_cast<int>( size );
   JackMidiData *data = static_cast<JackMidiData *> (apiData_);
 
   // Write full message to buffer
-  jack_ringbuffer_write( data->buffMessage, ( const char * ) &( *message )[0],
-                         message->size() );
+  jack_ringbuffer_write( data->buffMessage, ( const char * ) message, size );
   jack_ringbuffer_write( data->buffSize, ( char * ) &nBytes, sizeof( nBytes ) );
 }
 
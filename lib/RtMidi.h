@@ -318,6 +318,13 @@ class RtMidiIn : public RtMidi
   */
   double getMessage( std::vector<unsigned char> *message );
 
+  //! Returns the time the driver stamped the message being handed to the callback, in std::chrono::steady_clock nanoseconds.
+  /*!
+    Only valid when called from within the callback. Returns 0 if the
+    API does not supply a timestamp on that clock (ALSA and CoreMIDI do).
+  */
+  unsigned long long getDriverTimestamp( void );
+
   //! Set an error callback function to be invoked when an error has occured.
   /*!
     The callback function will be called whenever an error has occured. It is best
@@ -409,6 +416,39 @@ class RtMidiOut : public RtMidi
   */
   void sendMessage( std::vector<unsigned char> *message );
 
+  //! Immediately send a single message of \a size bytes out an open MIDI output port.
+  /*!
+      The bytes are handed to the API's encoder as they are, without an
+      intermediate copy or allocation (except for sysex on Windows MM).
+  */
+  void sendMessage( const unsigned char *message, size_t size );
+
+  //! Schedule a message for delivery at a std::chrono::steady_clock time, in nanoseconds.
+  /*!
+      Only APIs with a kernel scheduler (ALSA) support this; the others
+      return false and the message is not sent. Times in the past are
+      delivered right away.
+  */
+  bool sendMessageAt( const unsigned char *message, size_t size, unsigned long long steadyNanos );
+
+  //! Drop every message scheduled with sendMessageAt() that has not been delivered yet.
+  /*!
+      The API's queue is released as well and set up again by the next
+      sendMessageAt(). Also done by closePort().
+  */
+  void cancelScheduled( void );
+
+  //! Start collecting messages to be delivered together.
+  /*!
+      Messages sent until flushBatch() may be buffered by the API and
+      handed to the driver in one go. APIs without an output buffer
+      keep sending immediately.
+  */
+  void beginBatch( void );
+
+  //! Deliver everything buffered since beginBatch().
+  void flushBatch( void );
+
   //! Set an error callback function to be invoked when an error has occured.
   /*!
     The callback function will be called whenever an error has occured. It is best
@@ -475,6 +515,7 @@ class MidiInApi : public MidiApi
   void cancelCallback( void );
   virtual void ignoreTypes( bool midiSysex, bool midiTime, bool midiSense );
   double getMessage( std::vector<unsigned char> *message );
+  unsigned long long getDriverTimestamp( void ) const { return inputData_.driverNanos; }
 
   // A MIDI structure used internally by the class to store incoming
   // messages.  Each message represents one and only one MIDI message.
@@ -512,12 +553,13 @@ class MidiInApi : public MidiApi
     RtMidiIn::RtMidiCallback userCallback;
     void *userData;
     bool continueSysex;
+    unsigned long long driverNanos; // steady clock driver timestamp of the message being delivered, 0 if unknown
 
     // Default constructor.
   RtMidiInData()
   : ignoreFlags(7), doInput(false), firstMessage(true),
       apiData(0), usingCallback(false), userCallback(0), userData(0),
-      continueSysex(false) {}
+      continueSysex(false), driverNanos(0) {}
   };
 
  protected:
@@ -530,7 +572,12 @@ class MidiOutApi : public MidiApi
 
   MidiOutApi( void );
   virtual ~MidiOutApi( void );
-  virtual void sendMessage( std::vector<unsigned char> *message ) = 0;
+  void sendMessage( std::vector<unsigned char> *message ) { sendMessage( message->empty() ? 0 : &( *message )[0], message->size() ); }
+  virtual void sendMessage( const unsigned char *message, size_t size ) = 0;
+  virtual bool sendMessageAt( const unsigned char * /*message*/, size_t /*size*/, unsigned long long /*steadyNanos*/ ) { return false; }
+  virtual void cancelScheduled( void ) {}
+  virtual void beginBatch( void ) {}
+  virtual void flushBatch( void ) {}
 };
 
 // **************************************************************** //
@@ -550,6 +597,7 @@ inline unsigned int RtMidiIn :: getPortCount( void ) { return rtapi_->getPortCou
 inline std::string RtMidiIn :: getPortName( unsigned int portNumber ) { return rtapi_->getPortName( portNumber ); }
 inline void RtMidiIn :: ignoreTypes( bool midiSysex, bool midiTime, bool midiSense ) { ((MidiInApi *)rtapi_)->ignoreTypes( midiSysex, midiTime, midiSense ); }
 inline double RtMidiIn :: getMessage( std::vector<unsigned char> *message ) { return ((MidiInApi *)rtapi_)->getMessage( message ); }
+inline unsigned long long RtMidiIn :: getDriverTimestamp( void ) { return ((MidiInApi *)rtapi_)->getDriverTimestamp(); }
 inline void RtMidiIn :: setErrorCallback( RtMidiErrorCallback errorCallback, void *userData ) { rtapi_->setErrorCallback(errorCallback, userData); }
 
 inline RtMidi::Api RtMidiOut :: getCurrentApi( void ) throw() { return rtapi_->getCurrentApi(); }
@@ -560,6 +608,11 @@ inline bool RtMidiOut :: isPortOpen() const { return rtapi_->isPortOpen(); }
 inline unsigned int RtMidiOut :: getPortCount( void ) { return rtapi_->getPortCount(); }
 inline std::string RtMidiOut :: getPortName( unsigned int portNumber ) { return rtapi_->getPortName( portNumber ); }
 inline void RtMidiOut :: sendMessage( std::vector<unsigned char> *message ) { ((MidiOutApi *)rtapi_)->sendMessage( message ); }
+inline void RtMidiOut :: sendMessage( const unsigned char *message, size_t size ) { ((MidiOutApi *)rtapi_)->sendMessage( message, size ); }
+inline bool RtMidiOut :: sendMessageAt( const unsigned char *message, size_t size, unsigned long long steadyNanos ) { return ((MidiOutApi *)rtapi_)->sendMessageAt( message, size, steadyNanos ); }
+inline void RtMidiOut :: cancelScheduled( void ) { ((MidiOutApi *)rtapi_)->cancelScheduled(); }
+inline void RtMidiOut :: beginBatch( void ) { ((MidiOutApi *)rtapi_)->beginBatch(); }
+inline void RtMidiOut :: flushBatch( void ) { ((MidiOutApi *)rtapi_)->flushBatch(); }
 inline void RtMidiOut :: setErrorCallback( RtMidiErrorCallback errorCallback, void *userData ) { rtapi_->setErrorCallback(errorCallback, userData); }
 
 // **************************************************************** //
@@ -610,7 +663,7 @@ class MidiOutCore: public MidiOutApi
   void closePort( void );
   unsigned int getPortCount( void );
   std::string getPortName( unsigned int portNumber );
-  void sendMessage( std::vector<unsigned char> *message );
+  void sendMessage( const unsigned char *message, size_t size );
 
  protected:
   void initialize( const std::string& clientName );
@@ -650,7 +703,7 @@ class MidiOutJack: public MidiOutApi
   void closePort( void );
   unsigned int getPortCount( void );
   std::string getPortName( unsigned int portNumber );
-  void sendMessage( std::vector<unsigned char> *message );
+  void sendMessage( const unsigned char *message, size_t size );
 
  protected:
   std::string clientName;
@@ -690,10 +743,15 @@ class MidiOutAlsa: public MidiOutApi
   void closePort( void );
   unsigned int getPortCount( void );
   std::string getPortName( unsigned int portNumber );
-  void sendMessage( std::vector<unsigned char> *message );
+  void sendMessage( const unsigned char *message, size_t size );
+  bool sendMessageAt( const unsigned char *message, size_t size, unsigned long long steadyNanos );
+  void cancelScheduled( void );
+  void beginBatch( void );
+  void flushBatch( void );
 
  protected:
   void initialize( const std::string& clientName );
+  bool output( const unsigned char *message, size_t size, long long queueNanos );
 };
 
 #endif
@@ -727,7 +785,7 @@ class MidiOutWinMM: public MidiOutApi
   void closePort( void );
   unsigned int getPortCount( void );
   std::string getPortName( unsigned int portNumber );
-  void sendMessage( std::vector<unsigned char> *message );
+  void sendMessage( const unsigned char *message, size_t size );
 
  protected:
   void initialize( const std::string& clientName );
@@ -762,7 +820,7 @@ class MidiOutDummy: public MidiOutApi
   void closePort( void ) {}
   unsigned int getPortCount( void ) { return 0; }
   std::string getPortName( unsigned int /*portNumber*/ ) { return ""; }
-  void sendMessage( std::vector<unsigned char> * /*message*/ ) {}
+  void sendMessage( const unsigned char * /*message*/, size_t /*size*/ ) {}
 
  protected:
   void initialize( const std::string& /*clientName*/ ) {}
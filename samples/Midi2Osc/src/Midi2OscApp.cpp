@@ -85,6 +85,8 @@ void Midi2OscApp::setup() {
 
 	if (mMidiIn.getNumPorts() > 0) {
 		mMidiIn.listPorts();
+		// only the latest value of a swept fader needs to go out over OSC
+		mMidiIn.setCoalescing(true);
 		mMidiIn.openPort(0);
 		console() << "Opening MIDI port 0" << std::endl;
 		mMidiIn.midiSignal.connect(std::bind(&Midi2OscApp::midiListener, this, std::placeholders::_1));
@@ -0,0 +1,96 @@
+//
+//  MidiActiveNotes.cpp
+//
+//  See licence and credits in MidiActiveNotes.h.
+//
+
+#include "MidiActiveNotes.h"
+
+#if defined( _MSC_VER )
+	#include <intrin.h>
+#endif
+
+namespace cinder { namespace midi {
+
+	ActiveNotes::ActiveNotes()
+	{
+		mPort.store( 0 );
+		for( int ch = 0; ch < 16; ++ch ){
+			mBits[ch][0].store( 0 );
+			mBits[ch][1].store( 0 );
+			for( int note = 0; note < 128; ++note )
+				mOnTime[ch][note].store( 0 );
+		}
+	}
+
+	bool ActiveNotes::update( const Event &event ){
+		const uint8_t status = event.getStatus();
+		if( status != MIDI_NOTE_ON && status != MIDI_NOTE_OFF )
+			return false;
+
+		const int ch = event.getChannel() - 1;
+		const int note = event.data1 & 0x7F;
+		const uint64_t mask = uint64_t( 1 ) << ( note & 63 );
+		mPort.store( event.port, std::memory_order_relaxed );
+		if( status == MIDI_NOTE_ON && event.data2 > 0 ){
+			// time first, so a reader that sees the bit also sees when it was set
+			mOnTime[ch][note].store( event.time, std::memory_order_relaxed );
+			mBits[ch][note >> 6].fetch_or( mask, std::memory_order_release );
+		}
+		else {
+			mBits[ch][note >> 6].fetch_and( ~mask, std::memory_order_release );
+		}
+		return true;
+	}
+
+	void ActiveNotes::reset(){
+		for( int ch = 0; ch < 16; ++ch ){
+			mBits[ch][0].store( 0, std::memory_order_release );
+			mBits[ch][1].store( 0, std::memory_order_release );
+		}
+	}
+
+	bool ActiveNotes::isHeld( int channel, int note ) const{
+		note &= 0x7F;
+		return ( mBits[channel - 1][note >> 6].load( std::memory_order_acquire ) >> ( note & 63 ) ) & 1;
+	}
+
+	int ActiveNotes::getHeldCount( int channel ) const{
+		int count = 0;
+		const int first = channel ? channel - 1 : 0;
+		const int last = channel ? channel : 16;
+		for( int ch = first; ch < last; ++ch )
+			count += popCount( mBits[ch][0].load( std::memory_order_relaxed ) ) + popCount( mBits[ch][1].load( std::memory_order_relaxed ) );
+		return count;
+	}
+
+	int ActiveNotes::popCount( uint64_t bits ){
+#if defined( __GNUC__ ) || defined( __clang__ )
+		return __builtin_popcountll( bits );
+#else
+		bits = bits - ( ( bits >> 1 ) & 0x5555555555555555ULL );
+		bits = ( bits & 0x3333333333333333ULL ) + ( ( bits >> 2 ) & 0x3333333333333333ULL );
+		bits = ( bits + ( bits >> 4 ) ) & 0x0F0F0F0F0F0F0F0FULL;
+		return int( ( bits * 0x0101010101010101ULL ) >> 56 );
+#endif
+	}
+
+	int ActiveNotes::countTrailingZeros( uint64_t bits ){
+#if defined( __GNUC__ ) || defined( __clang__ )
+		return __builtin_ctzll( bits );
+#elif defined( _MSC_VER ) && defined( _WIN64 )
+		unsigned long index;
+		_BitScanForward64( &index, bits );
+		return int( index );
+#else
+		int count = 0;
+		while( !( bits & 1 ) && count < 64 ){
+			bits >>= 1;
+			++count;
+		}
+		return count;
+#endif
+	}
+
+}// namespace midi
+}// namespace cinder
@@ -0,0 +1,156 @@
+//
+//  MidiClockTracker.cpp
+//
+//  See licence and credits in MidiClockTracker.h.
+//
+
+#include "MidiClockTracker.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace cinder { namespace midi {
+
+	double ClockState::getBeats( uint32_t now ) const{
+		double ticks = this->ticks;
+		if( running && secondsPerTick > 0.0 ){
+			const double elapsed = (int32_t) ( now - tickTime ) * 1.0e-6 / secondsPerTick;
+			ticks += elapsed < 0.0 ? 0.0 : elapsed > 1.0 ? 1.0 : elapsed;
+		}
+		return ticks / TICKS_PER_BEAT;
+	}
+
+	double ClockState::getBeatPhase( uint32_t now ) const{
+		const double beats = getBeats( now );
+		return beats - std::floor( beats );
+	}
+
+	ClockTracker::ClockTracker(){
+		mSequence.store( 0 );
+		reset();
+	}
+
+	void ClockTracker::reset(){
+		mTickCount = 0;
+		mTickHead = 0;
+		mSecondsPerTick = 0.0;
+		mLastTick = 0;
+		mTicks = 0;
+		mRunning = false;
+		mAwaitingFirstTick = false;
+		publish( 0 );
+	}
+
+	bool ClockTracker::process( const Event &event ){
+		switch( event.status ){
+		case MIDI_TIME_CLOCK:
+			onTick( event.time );
+			return true;
+		case MIDI_START:
+			mTicks = 0;
+			mRunning = true;
+			mAwaitingFirstTick = true;
+			break;
+		case MIDI_CONTINUE:
+			mRunning = true;
+			mAwaitingFirstTick = true;
+			break;
+		case MIDI_STOP:
+			mRunning = false;
+			break;
+		case MIDI_SONG_POS_POINTER:
+			// in 16th notes, six ticks each
+			mTicks = (uint32_t) event.getValue() * 6;
+			break;
+		default:
+			return false;
+		}
+		publish( mLastTick );
+		return true;
+	}
+
+	void ClockTracker::onTick( uint32_t time ){
+		// a long gap means the clock stopped or jumped, start the fit over
+		if( mTickCount > 0 ){
+			const double interval = ( time - mLastTick ) * 1.0e-6;
+			const double expected = mSecondsPerTick > 0.0 ? mSecondsPerTick : 0.125;
+			if( interval > expected * 4.0 )
+				mTickCount = 0;
+		}
+		mLastTick = time;
+
+		if( mTickCount < WINDOW ){
+			mTickTimes[( mTickHead + mTickCount ) % WINDOW] = time;
+			++mTickCount;
+		}
+		else {
+			mTickTimes[mTickHead] = time;
+			mTickHead = ( mTickHead + 1 ) % WINDOW;
+		}
+
+		// least squares fit of tick time against tick index, relative to the oldest tick
+		uint32_t smoothed = time;
+		if( mTickCount >= 3 ){
+			const uint32_t origin = mTickTimes[mTickHead];
+			double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+			for( int i = 0; i < mTickCount; ++i ){
+				const double y = ( mTickTimes[( mTickHead + i ) % WINDOW] - origin ) * 1.0e-6;
+				sumX += i;
+				sumY += y;
+				sumXX += (double) i * i;
+				sumXY += i * y;
+			}
+			const double n = mTickCount;
+			const double slope = ( n * sumXY - sumX * sumY ) / ( n * sumXX - sumX * sumX );
+			const double intercept = ( sumY - slope * sumX ) / n;
+			if( slope > 0.0 ){
+				mSecondsPerTick = slope;
+				smoothed = origin + (uint32_t) std::lround( ( intercept + slope * ( n - 1 ) ) * 1.0e6 );
+			}
+		}
+		else if( mTickCount == 2 ){
+			mSecondsPerTick = ( time - mTickTimes[mTickHead] ) * 1.0e-6;
+		}
+
+		if( mRunning ){
+			if( mAwaitingFirstTick )
+				mAwaitingFirstTick = false;
+			else
+				++mTicks;
+		}
+		publish( smoothed );
+	}
+
+	void ClockTracker::publish( uint32_t tickTime ){
+		uint64_t secondsPerTick;
+		std::memcpy( &secondsPerTick, &mSecondsPerTick, sizeof( secondsPerTick ) );
+
+		// odd sequence numbers tell readers a write is in progress
+		mSequence.store( mSequence.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_release );
+		mStateRunning.store( mRunning, std::memory_order_relaxed );
+		mStateTicks.store( mTicks, std::memory_order_relaxed );
+		mStateTickTime.store( tickTime, std::memory_order_relaxed );
+		mStateSecondsPerTick.store( secondsPerTick, std::memory_order_relaxed );
+		mSequence.store( mSequence.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+	}
+
+	void ClockTracker::read( ClockState &state ) const{
+		uint32_t begin, end;
+		uint64_t secondsPerTick;
+		do {
+			begin = mSequence.load( std::memory_order_acquire );
+			if( begin & 1 )
+				continue;
+			state.running = mStateRunning.load( std::memory_order_relaxed );
+			state.ticks = mStateTicks.load( std::memory_order_relaxed );
+			state.tickTime = mStateTickTime.load( std::memory_order_relaxed );
+			secondsPerTick = mStateSecondsPerTick.load( std::memory_order_relaxed );
+			std::atomic_thread_fence( std::memory_order_acquire );
+			end = mSequence.load( std::memory_order_relaxed );
+		} while( ( begin & 1 ) || begin != end );
+		std::memcpy( &state.secondsPerTick, &secondsPerTick, sizeof( secondsPerTick ) );
+	}
+
+}// namespace midi
+}// namespace cinder
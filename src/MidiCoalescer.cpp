@@ -0,0 +1,77 @@
+//
+//  MidiCoalescer.cpp
+//
+//  See licence and credits in MidiCoalescer.h.
+//
+
+#include <cstring>
+
+#include "MidiCoalescer.h"
+
+namespace cinder { namespace midi {
+
+	namespace {
+		inline uint64_t pack( const Event &event ) {
+			uint64_t bits;
+			std::memcpy( &bits, &event, sizeof( bits ) );
+			return bits;
+		}
+
+		inline Event unpack( uint64_t bits ) {
+			Event event;
+			std::memcpy( &event, &bits, sizeof( event ) );
+			return event;
+		}
+	}
+
+	Coalescer::Coalescer(){
+		for( Slot &slot : mSlots ){
+			slot.event.store( 0 );
+			slot.pending.store( false );
+		}
+		mElidedCount.store( 0 );
+	}
+
+	bool Coalescer::isCoalescable( const Event &event ){
+		switch( event.getStatus() ){
+		case MIDI_CONTROL_CHANGE:
+		case MIDI_PITCH_BEND:
+		case MIDI_AFTERTOUCH:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	int Coalescer::slotIndex( const Event &event ){
+		int base = ( event.getChannel() - 1 ) * kSlotsPerChannel;
+		switch( event.getStatus() ){
+		case MIDI_PITCH_BEND:
+			return base + 128;
+		case MIDI_AFTERTOUCH:
+			return base + 129;
+		default:
+			return base + ( event.data1 & 0x7F );
+		}
+	}
+
+	bool Coalescer::store( const Event &event ){
+		Slot &slot = mSlots[slotIndex( event )];
+		slot.event.store( pack( event ), std::memory_order_relaxed );
+		// the release half publishes the value above to whoever clears the flag
+		if( slot.pending.exchange( true, std::memory_order_acq_rel ) ){
+			mElidedCount.fetch_add( 1, std::memory_order_relaxed );
+			return false;
+		}
+		return true;
+	}
+
+	Event Coalescer::take( const Event &marker ){
+		Slot &slot = mSlots[slotIndex( marker )];
+		// clear first, so an update racing with us queues a fresh marker instead of being lost
+		slot.pending.exchange( false, std::memory_order_acq_rel );
+		return unpack( slot.event.load( std::memory_order_acquire ) );
+	}
+
+}// namespace midi
+}// namespace cinder
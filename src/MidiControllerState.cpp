@@ -0,0 +1,135 @@
+//
+//  MidiControllerState.cpp
+//
+//  See licence and credits in MidiControllerState.h.
+//
+
+#include "MidiControllerState.h"
+
+namespace cinder { namespace midi {
+
+	namespace {
+		inline void markChanged( std::atomic<uint64_t> (&mask)[2], int index ) {
+			mask[index >> 6].fetch_or( uint64_t( 1 ) << ( index & 63 ), std::memory_order_relaxed );
+		}
+	}
+
+	ControllerState::ControllerState(){
+		mSequence.store( 0 );
+		reset();
+	}
+
+	void ControllerState::beginWrite(){
+		// odd sequence numbers tell readers a write is in progress
+		mSequence.store( mSequence.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_release );
+	}
+
+	void ControllerState::endWrite(){
+		mSequence.store( mSequence.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+	}
+
+	void ControllerState::reset(){
+		beginWrite();
+		for( int ch = 0; ch < 16; ++ch ){
+			for( int i = 0; i < 128; ++i ){
+				mNotes[ch][i].store( 0, std::memory_order_relaxed );
+				mPolyPressure[ch][i].store( 0, std::memory_order_relaxed );
+				mControllers[ch][i].store( 0, std::memory_order_relaxed );
+			}
+			mChannelPressure[ch].store( 0, std::memory_order_relaxed );
+			mProgram[ch].store( 0, std::memory_order_relaxed );
+			mPitchBend[ch].store( 8192, std::memory_order_relaxed );
+			for( int w = 0; w < 2; ++w ){
+				mChangedNotes[ch][w].store( ~uint64_t( 0 ), std::memory_order_relaxed );
+				mChangedPolyPressure[ch][w].store( ~uint64_t( 0 ), std::memory_order_relaxed );
+				mChangedControllers[ch][w].store( ~uint64_t( 0 ), std::memory_order_relaxed );
+			}
+		}
+		mChangedChannelPressure.store( 0xFFFF, std::memory_order_relaxed );
+		mChangedProgram.store( 0xFFFF, std::memory_order_relaxed );
+		mChangedPitchBend.store( 0xFFFF, std::memory_order_relaxed );
+		endWrite();
+	}
+
+	void ControllerState::update( const Event &event ){
+		if( !event.isChannelMessage() )
+			return;
+
+		const int ch = event.getChannel() - 1;
+		const int index = event.data1 & 0x7F;
+
+		beginWrite();
+		switch( event.getStatus() ){
+		case MIDI_NOTE_ON:
+			// a note on with velocity 0 is a note off
+			mNotes[ch][index].store( event.data2, std::memory_order_relaxed );
+			markChanged( mChangedNotes[ch], index );
+			break;
+		case MIDI_NOTE_OFF:
+			mNotes[ch][index].store( 0, std::memory_order_relaxed );
+			markChanged( mChangedNotes[ch], index );
+			break;
+		case MIDI_POLY_AFTERTOUCH:
+			mPolyPressure[ch][index].store( event.data2, std::memory_order_relaxed );
+			markChanged( mChangedPolyPressure[ch], index );
+			break;
+		case MIDI_CONTROL_CHANGE:
+			mControllers[ch][index].store( event.data2, std::memory_order_relaxed );
+			markChanged( mChangedControllers[ch], index );
+			break;
+		case MIDI_AFTERTOUCH:
+			mChannelPressure[ch].store( event.data1, std::memory_order_relaxed );
+			mChangedChannelPressure.fetch_or( uint16_t( 1 << ch ), std::memory_order_relaxed );
+			break;
+		case MIDI_PROGRAM_CHANGE:
+			mProgram[ch].store( event.data1, std::memory_order_relaxed );
+			mChangedProgram.fetch_or( uint16_t( 1 << ch ), std::memory_order_relaxed );
+			break;
+		case MIDI_PITCH_BEND:
+			mPitchBend[ch].store( (uint16_t) event.getValue(), std::memory_order_relaxed );
+			mChangedPitchBend.fetch_or( uint16_t( 1 << ch ), std::memory_order_relaxed );
+			break;
+		default:
+			break;
+		}
+		endWrite();
+	}
+
+	void ControllerState::read( ControllerSnapshot &snapshot ){
+		// take the masks first: anything written from here on is flagged again for the next read
+		for( int ch = 0; ch < 16; ++ch ){
+			for( int w = 0; w < 2; ++w ){
+				snapshot.changedNotes[ch][w] = mChangedNotes[ch][w].exchange( 0, std::memory_order_acq_rel );
+				snapshot.changedPolyPressure[ch][w] = mChangedPolyPressure[ch][w].exchange( 0, std::memory_order_acq_rel );
+				snapshot.changedControllers[ch][w] = mChangedControllers[ch][w].exchange( 0, std::memory_order_acq_rel );
+			}
+		}
+		snapshot.changedChannelPressure = mChangedChannelPressure.exchange( 0, std::memory_order_acq_rel );
+		snapshot.changedProgram = mChangedProgram.exchange( 0, std::memory_order_acq_rel );
+		snapshot.changedPitchBend = mChangedPitchBend.exchange( 0, std::memory_order_acq_rel );
+
+		uint32_t begin, end;
+		do {
+			begin = mSequence.load( std::memory_order_acquire );
+			if( begin & 1 )
+				continue;
+
+			for( int ch = 0; ch < 16; ++ch ){
+				for( int i = 0; i < 128; ++i ){
+					snapshot.notes[ch][i] = mNotes[ch][i].load( std::memory_order_relaxed );
+					snapshot.polyPressure[ch][i] = mPolyPressure[ch][i].load( std::memory_order_relaxed );
+					snapshot.controllers[ch][i] = mControllers[ch][i].load( std::memory_order_relaxed );
+				}
+				snapshot.channelPressure[ch] = mChannelPressure[ch].load( std::memory_order_relaxed );
+				snapshot.program[ch] = mProgram[ch].load( std::memory_order_relaxed );
+				snapshot.pitchBend[ch] = mPitchBend[ch].load( std::memory_order_relaxed );
+			}
+
+			std::atomic_thread_fence( std::memory_order_acquire );
+			end = mSequence.load( std::memory_order_relaxed );
+		} while( ( begin & 1 ) || begin != end );
+	}
+
+}// namespace midi
+}// namespace cinder
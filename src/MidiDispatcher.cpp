@@ -0,0 +1,98 @@
+//
+//  MidiDispatcher.cpp
+//
+//  See licence and credits in MidiDispatcher.h.
+//
+
+#include "MidiDispatcher.h"
+
+#include <cassert>
+
+namespace cinder { namespace midi {
+
+	Dispatcher::Dispatcher()
+		: mOffsets( SLOT_COUNT + 1, 0 ), mNextId( 1 )
+	{
+	}
+
+	size_t Dispatcher::on( uint8_t status, int channel, const Handler &handler ){
+		return add( status, channel, -1, handler );
+	}
+
+	size_t Dispatcher::onControlChange( int channel, int controller, const Handler &handler ){
+		return add( MIDI_CONTROL_CHANGE, channel, controller, handler );
+	}
+
+	size_t Dispatcher::add( uint8_t status, int channel, int controller, const Handler &handler ){
+		// a data byte has no slot, and a channel out of range must not widen to all channels
+		const bool isSystem = status >= MIDI_SYSEX;
+		assert( status >= 0x80 && "dispatcher status must be a status byte" );
+		assert( ( isSystem || ( channel >= 0 && channel <= 16 ) ) && "dispatcher channel must be 1 - 16, or 0 for all" );
+		if( status < 0x80 || ( ! isSystem && ( channel < 0 || channel > 16 ) ) )
+			return 0;
+
+		Entry entry;
+		entry.id = mNextId++;
+		entry.status = isSystem ? status : uint8_t( status & 0xF0 );
+		entry.channel = uint8_t( isSystem ? 0 : channel );
+		entry.controller = int16_t( controller < 0 ? -1 : controller & 0x7F );
+		entry.handler = handler;
+		mHandlers.push_back( entry );
+		rebuild();
+		return entry.id;
+	}
+
+	void Dispatcher::remove( size_t id ){
+		for( auto it = mHandlers.begin(); it != mHandlers.end(); ++it ){
+			if( it->id == id ){
+				mHandlers.erase( it );
+				rebuild();
+				return;
+			}
+		}
+	}
+
+	void Dispatcher::clear(){
+		mHandlers.clear();
+		rebuild();
+	}
+
+	void Dispatcher::rebuild(){
+		// two passes over every slot a handler covers: count, then fill in registration order
+		std::vector<uint32_t> counts( SLOT_COUNT, 0 );
+		auto forEachSlot = []( const Entry &entry, const std::function<void(int)> &fn ){
+			if( entry.status >= MIDI_SYSEX ){
+				fn( SYSTEM_SLOTS + ( entry.status & 0x0F ) );
+				return;
+			}
+			const int first = entry.channel ? entry.channel - 1 : 0;
+			const int last = entry.channel ? entry.channel : 16;
+			for( int ch = first; ch < last; ++ch ){
+				if( entry.status == MIDI_CONTROL_CHANGE ){
+					if( entry.controller >= 0 )
+						fn( CONTROLLER_SLOTS + ch * 128 + entry.controller );
+					else
+						for( int cc = 0; cc < 128; ++cc )
+							fn( CONTROLLER_SLOTS + ch * 128 + cc );
+				}
+				else {
+					fn( ( ( entry.status >> 4 ) - 8 ) * 16 + ch );
+				}
+			}
+		};
+
+		for( const Entry &entry : mHandlers )
+			forEachSlot( entry, [&counts]( int slot ){ ++counts[slot]; } );
+
+		mOffsets[0] = 0;
+		for( int slot = 0; slot < SLOT_COUNT; ++slot )
+			mOffsets[slot + 1] = mOffsets[slot] + counts[slot];
+
+		mIndices.assign( mOffsets[SLOT_COUNT], 0 );
+		std::vector<uint32_t> cursor( mOffsets.begin(), mOffsets.end() - 1 );
+		for( uint32_t i = 0; i < mHandlers.size(); ++i )
+			forEachSlot( mHandlers[i], [this, &cursor, i]( int slot ){ mIndices[cursor[slot]++] = i; } );
+	}
+
+}// namespace midi
+}// namespace cinder
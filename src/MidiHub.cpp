@@ -60,16 +60,20 @@ namespace cinder { namespace midi {
 	// --------------------------------------------------------------------------------------
 	void Hub::connectAll() {
 		
-		for ( uint8_t i = 0 ; i < midii.getPortCount() ; i++ )
+		// one enumeration for all ports instead of one per name
+		PortRegistry::get().refresh();
+		std::vector<PortInfo> ports = PortRegistry::get().getInputs();
+		for ( size_t i = 0 ; i < ports.size() ; i++ )
 		{
-			if (this->isDeviceConnected(midii.getPortName(i)))
+			if (this->isDeviceConnected(ports[i].name))
 				continue;
 			
-			printf("MIDI HUB: connecting to %i: %s\n",i,midii.getPortName(i).c_str());
+			printf("MIDI HUB: connecting to %u: %s\n",ports[i].index,ports[i].name.c_str());
 			
 			// Connect IN
 			midi::Input *in = new midi::Input();
-			in->openPort(i);
+			in->setPollingEnabled(mPolling, mPollCapacity);
+			in->openPort(ports[i].index);
 			midiInPool.push_back(in);
 			
 			// Connect OUT
@@ -93,7 +97,7 @@ namespace cinder { namespace midi {
 		
 		// new devices?
 		//printf("MIDI CHECK...\n");
-		if ( midiInPool.size() != midii.getPortCount() )
+		if ( PortRegistry::get().refresh() || midiInPool.size() != PortRegistry::get().getInputs().size() )
 			this->connectAll();
 	}
 	
@@ -111,24 +115,62 @@ namespace cinder { namespace midi {
 	}
 	
 	// --------------------------------------------------------------------------------------
-	//bool Hub::hasWaitingMessages() {
-	//	this->update();
-	//	for ( int n = 0 ; n < midiInPool.size() ; n++ )
-	//		if ( midiInPool[n]->hasWaitingMessages() )
-	//			return true;
-	//	// No messages!
-	//	return false;
-	//}
-	//
-	//// --------------------------------------------------------------------------------------
-	//bool Hub::getNextMessage( Message* msg ) {
-	//	this->update();
-	//	for ( int n = 0 ; n < midiInPool.size() ; n++ )
-	//		if ( midiInPool[n]->getNextMessage( msg ) )
-	//			return true;
-	//	// No messages!
-	//	return false;
-	//}
+	void Hub::setPollingEnabled( bool enabled, size_t capacity ) {
+		mPolling = enabled;
+		mPollCapacity = capacity;
+		// the queues must be in place before the ports start delivering
+		this->disconnectAll();
+		this->connectAll();
+	}
+	
+	// --------------------------------------------------------------------------------------
+	bool Hub::hasWaitingMessages() {
+		for ( size_t n = 0 ; n < midiInPool.size() ; n++ )
+			if ( midiInPool[n]->hasWaitingMessages() )
+				return true;
+		// No messages!
+		return false;
+	}
+	
+	// --------------------------------------------------------------------------------------
+	bool Hub::getNextMessage( Message* msg ) {
+		for ( size_t n = 0 ; n < midiInPool.size() ; n++ )
+			if ( midiInPool[n]->getNextMessage( msg ) )
+				return true;
+		// No messages!
+		return false;
+	}
+	
+	// --------------------------------------------------------------------------------------
+	size_t Hub::poll( Event* out, size_t max ) {
+		size_t count = 0;
+		for ( size_t n = 0 ; n < midiInPool.size() && count < max ; n++ )
+			count += midiInPool[n]->poll( out + count, max - count );
+		return count;
+	}
+	
+	// --------------------------------------------------------------------------------------
+	Input* Hub::findInput( uint8_t port ) const {
+		for ( size_t n = 0 ; n < midiInPool.size() ; n++ )
+			if ( (uint8_t) midiInPool[n]->getPort() == port )
+				return midiInPool[n];
+		return nullptr;
+	}
+	
+	const uint8_t* Hub::getSysexData( const Event &event ) const {
+		Input *input = findInput( event.port );
+		return input ? input->getSysexData( event ) : nullptr;
+	}
+	
+	size_t Hub::getSysexSize( const Event &event ) const {
+		Input *input = findInput( event.port );
+		return input ? input->getSysexSize( event ) : 0;
+	}
+	
+	void Hub::releaseSysex( const Event &event ) {
+		if ( Input *input = findInput( event.port ) )
+			input->releaseSysex( event );
+	}
 	
 	
 } // namespace midi
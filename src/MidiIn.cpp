@@ -9,6 +9,9 @@
 
 #include "MidiIn.h"
 
+#include <cmath>
+#include <thread>
+
 namespace cinder { namespace midi {
 
 	void MidiInCallback(double deltatime, std::vector<unsigned char> *message, void *userData){
@@ -18,20 +21,30 @@ namespace cinder { namespace midi {
 
 	Input::Input(){
 		mMidiIn = new RtMidiIn();
-		mNumPorts = mMidiIn->getPortCount();
+		mSysexPool.reset(new SysexPool());
+		resetMainQueue(4096);
+		mFilterControllers[0].store(~uint64_t(0));
+		mFilterControllers[1].store(~uint64_t(0));
+		// the shared snapshot saves every new input a full port enumeration
+		mNumPorts = (unsigned int) PortRegistry::get().getInputs().size();
 		mMidiIn->getCurrentApi();
 	}
 
 	Input::~Input(){
+		// nobody is left to receive them
+		mReleaseNotesOnClose = false;
 		closePort();
 	}
 
 	void Input::listPorts(){
+		PortRegistry::get().refresh();
+		std::vector<PortInfo> ports = PortRegistry::get().getInputs();
+		mNumPorts = (unsigned int) ports.size();
+		mPortNames.clear();
 		std::cout << "MidiIn: " << mNumPorts << " available." << std::endl;
-		for (size_t i = 0; i < mNumPorts; ++i){
-			std::cout << i << ": " << mMidiIn->getPortName(i).c_str() << std::endl;
-			std::string name( mMidiIn->getPortName( i ).c_str() ); // strip null chars introduced by rtmidi
-			mPortNames.push_back( name );
+		for (const PortInfo &port : ports){
+			std::cout << port.index << ": " << port.name << std::endl;
+			mPortNames.push_back( port.name );
 		}
 	}
 
@@ -41,8 +54,16 @@ namespace cinder { namespace midi {
 	}
 
 	std::string Input::getPortName(int number){
+		if (number < 0 || (unsigned int) number >= mNumPorts)
+			throw MidiExcPortNotAvailable();
+		return PortRegistry::get().getInputName(number);
+	}
 
-		return mPortNames.at(number);
+	void Input::openPort(const std::string &name){
+		const int port = PortRegistry::get().findInput(name);
+		if (port < 0)
+			throw MidiExcPortNotAvailable();
+		openPort((unsigned int) port);
 	}
 
 	void Input::openPort(unsigned int port){
@@ -55,7 +76,10 @@ namespace cinder { namespace midi {
 		}
 
 		mPort = port;
-		mName = mMidiIn->getPortName(port);
+		mName = PortRegistry::get().getInputName(port);
+		// time base for the 32 bit event timestamps, paired with the app clock so they can be mapped onto it
+		mEpochNanos = getNowNanos();
+		mEpochAppSeconds = ci::app::App::get() ? ci::app::getElapsedSeconds() : 0.0;
 
 		mMidiIn->openPort(mPort);
 
@@ -67,77 +91,520 @@ namespace cinder { namespace midi {
 	void Input::closePort(){
 		mMidiIn->closePort();
 		mMidiIn->cancelCallback();
+
+		// the callback is gone, so this thread can stand in for the midi thread
+		if (mReleaseNotesOnClose) {
+			std::lock_guard<std::mutex> lock( mProducerMutex );
+			const uint32_t time = (uint32_t) ((getNowNanos() - mEpochNanos) / 1000);
+			mActiveNotes.releaseAll( [this](const Event &noteOff){ processEvent( noteOff ); }, time );
+		}
 	}
 
 	void Input::processMessage(double deltatime, std::vector<unsigned char> *message){
-		unsigned int numBytes = message->size();
-
-		// solution for proper reading anything above MIDI_TIME_CODE goes to miguelvb
-		// http://forum.openframeworks.cc/t/incorrect-handling-of-midiin-messages-in-ofxmidi-solved/8719
-		
-
-			Message msg;
-			msg.port = mPort;
-			if((message->at(0)) >= MIDI_SYSEX) {
-				msg.status = (MidiStatus)(message->at(0) & 0xFF);
-				msg.channel = 0;
-			} else {
-				msg.status = (MidiStatus) (message->at(0) & 0xF0);
-				msg.channel = (int) (message->at(0) & 0x0F)+1;
+		// only meaningful while RtMidi is inside the callback, which is where this is called from
+		processMessage(deltatime, message, mMidiIn->getDriverTimestamp());
+	}
+
+	void Input::processMessage(double /*deltatime*/, std::vector<unsigned char> *message, uint64_t driverNanos){
+		// stamp first thing on callback entry; RtMidi's deltatime is a lossy delta and not used
+		const uint64_t nanos = getNowNanos();
+		if (mLatency && driverNanos != 0 && driverNanos <= nanos)
+			mLatency[LATENCY_DRIVER_TO_CALLBACK].record(nanos - driverNanos);
+		// the event keeps the raw bytes, status type and channel are split by its accessors.
+		Event event = decode(message->data(), message->size(), (uint8_t) mPort, (uint32_t) ((nanos - mEpochNanos) / 1000));
+		if (event.status == MIDI_UNKNOWN)
+			return;
+
+		// filtered events never touch the producer lock; only this thread runs the filter
+		if (mFilterEnabled.load(std::memory_order_relaxed) && !passesFilter(event)){
+			mFilteredCount.store(mFilteredCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			return;
+		}
+
+		// uncontended unless releaseStuckNotes() is feeding note offs in right now
+		std::lock_guard<std::mutex> lock(mProducerMutex);
+
+		if (event.status == MIDI_SYSEX){
+			int handle = mSysexPool->store(message->data(), message->size());
+			if (handle == SysexPool::INVALID_HANDLE)
+				return;
+
+			event.data1 = (uint8_t) (handle & 0x7F);
+			event.data2 = (uint8_t) (handle >> 7);
+			processEvent(event);
+			// every queue that took the event holds its own reference
+			mSysexPool->release(handle);
+		}
+		else {
+			processEvent(event);
+		}
+
+		if (mLatency)
+			mLatency[LATENCY_CALLBACK_TO_THREAD_SIGNAL].record(getNowNanos() - nanos);
+	}
+
+	void Input::processEvent(const Event &event){
+		if (mClockTracker && mClockTracker->process( event ) && mConsumeClock && event.status == MIDI_TIME_CLOCK)
+			return;
+		if (mTimecodeTracker) {
+			if (event.status == MIDI_SYSEX)
+				mTimecodeTracker->processSysex( getSysexData( event ), getSysexSize( event ), event.time );
+			else if (mTimecodeTracker->process( event ) && mConsumeQuarterFrames)
+				return;
+		}
+
+		mControllerState.update( event );
+		mActiveNotes.update( event );
+		if (mMpeTracker)
+			mMpeTracker->process( event );
+
+		if (mParameterAssembler) {
+			bool consumed;
+			{
+				std::lock_guard<std::mutex> lock( mParameterMutex );
+				consumed = mParameterAssembler->process( event, [this](const ParameterEvent &parameter){ emitParameter( parameter ); } );
+			}
+			if (consumed && mConsumeParameterControllers)
+				return;
+		}
+
+		if (mPollQueue) {
+			retainSysex( event );
+			if (!mPollQueue->push( event )) {
+				mPollOverflowCount.fetch_add( 1, std::memory_order_relaxed );
+				releaseSysex( event );
+			}
+		}
+
+		midiEventThreadSignal.emit( event );
+		// only pay for the wide Message when someone still listens for it
+		if (midiThreadSignal.getNumSlots() > 0)
+			midiThreadSignal.emit( Message( event ) );
+		if (!midiThreadHandlers.empty())
+			midiThreadHandlers.dispatch( event );
+
+		if (mDispatchToMainThread)
+			dispatchMainThread( event );
+	}
+
+	void Input::emitParameter(const ParameterEvent &parameter){
+		midiParameterThreadSignal.emit( parameter );
+		if (!mDispatchToMainThread || midiParameterSignal.getNumSlots() == 0)
+			return;
+
+		// the parameter goes first, so the consumer always finds it behind its marker. If the
+		// marker is then refused, the parameter is skipped when the next marker is taken.
+		const uint32_t sequence = mParameterSequence++ & 0xFFFFFF;
+		if (!mParameterQueue->push( QueuedParameter{ sequence, parameter } )) {
+			mQueueOverflowCount.fetch_add( 1, std::memory_order_relaxed );
+			return;
+		}
+		dispatchMainThread( Event( MIDI_UNKNOWN, (uint8_t) sequence, (uint8_t) (sequence >> 8), (uint8_t) (sequence >> 16), parameter.time ) );
+	}
+
+	bool Input::takeParameter(const Event &marker, ParameterEvent *parameter){
+		const uint32_t sequence = marker.data1 | (marker.data2 << 8) | (marker.port << 16);
+		QueuedParameter queued;
+		while (mParameterQueue->pop( queued )) {
+			if (queued.sequence == sequence) {
+				*parameter = queued.parameter;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Input::expireParameters(){
+		// never wait for the midi thread; if it holds the lock it is expiring them itself
+		std::unique_lock<std::mutex> lock( mParameterMutex, std::try_to_lock );
+		if (!lock || !mParameterAssembler || !mParameterAssembler->hasPending())
+			return;
+		const uint32_t now = (uint32_t) ((getNowNanos() - mEpochNanos) / 1000);
+		mParameterAssembler->expire( now, [this](const ParameterEvent &parameter){
+			midiParameterThreadSignal.emit( parameter );
+			if (mDispatchToMainThread)
+				midiParameterSignal.emit( parameter );
+		});
+	}
+
+	void Input::setParameterAssembly(bool enabled, uint32_t lsbTimeoutMicros, bool consumeControllers){
+		mConsumeParameterControllers = consumeControllers;
+		if (enabled)
+			mParameterAssembler.reset(new ParameterAssembler(lsbTimeoutMicros));
+		else
+			mParameterAssembler.reset();
+		connectUpdate();
+	}
+
+	void Input::connectUpdate(){
+		mUpdateConnection.disconnect();
+		if ((mBatched || mParameterAssembler) && ci::app::App::get())
+			mUpdateConnection = ci::app::App::get()->getSignalUpdate().connect( [this](){ update(); });
+	}
+
+	int Input::releaseStuckNotes(double maxHeldSeconds){
+		// stands in for the midi thread, so the note offs reach every table, queue and signal
+		std::lock_guard<std::mutex> lock( mProducerMutex );
+		const uint32_t now = (uint32_t) ((getNowNanos() - mEpochNanos) / 1000);
+		return mActiveNotes.releaseOlderThan( now, (uint32_t) (maxHeldSeconds * 1e6), [this](const Event &noteOff){ processEvent( noteOff ); });
+	}
+
+	void Input::setClockTracking(bool enabled, bool consumeClock){
+		mConsumeClock = consumeClock;
+		if (enabled)
+			mClockTracker.reset(new ClockTracker());
+		else
+			mClockTracker.reset();
+	}
+
+	double Input::getBeats() const{
+		if (!mClockTracker)
+			return 0.0;
+		ClockState state;
+		mClockTracker->read( state );
+		return state.getBeats( (uint32_t) ((getNowNanos() - mEpochNanos) / 1000) );
+	}
+
+	double Input::getBeatPhase() const{
+		const double beats = getBeats();
+		return beats - std::floor( beats );
+	}
+
+	void Input::setTimecodeTracking(bool enabled, bool consumeQuarterFrames){
+		mConsumeQuarterFrames = consumeQuarterFrames;
+		if (enabled)
+			mTimecodeTracker.reset(new TimecodeTracker());
+		else
+			mTimecodeTracker.reset();
+	}
+
+	double Input::getTimecodeSeconds() const{
+		if (!mTimecodeTracker)
+			return 0.0;
+		Timecode timecode;
+		mTimecodeTracker->read( timecode );
+		return timecode.getSeconds( (uint32_t) ((getNowNanos() - mEpochNanos) / 1000) );
+	}
+
+	bool Input::isTimecodeRunning() const{
+		if (!mTimecodeTracker)
+			return false;
+		Timecode timecode;
+		mTimecodeTracker->read( timecode, (uint32_t) ((getNowNanos() - mEpochNanos) / 1000) );
+		return timecode.running;
+	}
+
+	void Input::setMpeTracking(bool enabled){
+		if (enabled)
+			mMpeTracker.reset(new MpeTracker());
+		else
+			mMpeTracker.reset();
+	}
+
+	void Input::dispatchMainThread(const Event &event){
+		const bool coalescable = mCoalescer && Coalescer::isCoalescable( event );
+		// a pending update for the same controller will pick up this value
+		if (coalescable && !mCoalescer->store( event ))
+			return;
+
+		retainSysex( event );
+		if (!enqueueMainThread( event )) {
+			mQueueOverflowCount.fetch_add( 1, std::memory_order_relaxed );
+			discardMainThread( event );
+			return;
+		}
+
+		mQueueEnqueuedCount.fetch_add( 1, std::memory_order_relaxed );
+		const size_t depth = mMainQueue->size();
+		if (depth > mQueueHighWaterMark.load( std::memory_order_relaxed ))
+			mQueueHighWaterMark.store( depth, std::memory_order_relaxed );
+
+		// one task drains everything that is waiting, later events ride along
+		if (!mBatched && !mDrainScheduled.exchange( true, std::memory_order_acq_rel ))
+			ci::app::App::get()->dispatchAsync( [this](){ drainMainQueue(); });
+	}
+
+	bool Input::enqueueMainThread(const Event &event){
+		switch (mOverflowPolicy) {
+		case OVERFLOW_DROP_OLDEST:
+			// push into the headroom and have the consumer skip one from the front instead
+			if (mMainQueue->size() < mQueueLimit)
+				return mMainQueue->push( event );
+			if (!mMainQueue->push( event ))
+				return false;
+			mDropOldestCount.fetch_add( 1, std::memory_order_relaxed );
+			mQueueOverflowCount.fetch_add( 1, std::memory_order_relaxed );
+			return true;
+		case OVERFLOW_BLOCK: {
+			const uint64_t deadline = getNowNanos() + (uint64_t) mBlockTimeoutMicros * 1000;
+			while (mMainQueue->size() >= mQueueLimit) {
+				if (getNowNanos() >= deadline)
+					return false;
+				std::this_thread::sleep_for( std::chrono::microseconds( 50 ) );
 			}
+			return mMainQueue->push( event );
+		}
+		default:
+			return mMainQueue->size() < mQueueLimit && mMainQueue->push( event );
+		}
+	}
+
+	void Input::discardMainThread(const Event &event){
+		releaseSysex( event );
+		// release the slot, otherwise the controller would never be delivered again
+		if (mCoalescer && Coalescer::isCoalescable( event ))
+			mCoalescer->take( event );
+	}
 
+	void Input::recordMainThreadLatency(const Event &event){
+		const uint64_t now = getNowNanos();
+		const uint64_t stamp = getTimestampNanos( event );
+		mLatency[LATENCY_CALLBACK_TO_MAIN_THREAD].record( now > stamp ? now - stamp : 0 );
+	}
+
+	void Input::setLatencyInstrumentation(bool enabled){
+		if (enabled)
+			mLatency.reset(new LatencyHistogram[LATENCY_STAGE_COUNT]);
+		else
+			mLatency.reset();
+	}
+
+	const LatencyHistogram* Input::getLatencyHistogram(LatencyStage stage) const{
+		return mLatency ? &mLatency[stage] : nullptr;
+	}
+
+	void Input::resetLatency(){
+		if (!mLatency)
+			return;
+
+		for (int i = 0; i < LATENCY_STAGE_COUNT; ++i)
+			mLatency[i].reset();
+	}
+
+	void Input::setBatchedDelivery(bool batched, size_t capacity){
+		mBatched = batched;
+		resetMainQueue(capacity);
+		connectUpdate();
+	}
+
+	void Input::setOverflowPolicy(OverflowPolicy policy, size_t capacity, uint32_t blockTimeoutMicros){
+		mOverflowPolicy = policy;
+		mBlockTimeoutMicros = blockTimeoutMicros;
+		if (policy == OVERFLOW_COALESCE_CONTROLLERS && !mCoalescer)
+			mCoalescer.reset(new Coalescer());
+		resetMainQueue(capacity);
+	}
+
+	void Input::resetMainQueue(size_t capacity){
+		mMainQueue.reset(new RingBuffer<Event>(capacity * 2));
+		mQueueLimit = mMainQueue->capacity() / 2;
+		mDropOldestCount.store(0, std::memory_order_relaxed);
+		mDrainBuffer.reset(new Event[mMainQueue->capacity()]);
+		mParameterQueue.reset(new RingBuffer<QueuedParameter>(mMainQueue->capacity()));
+		mBatch.clear();
+		mBatch.reserve(mMainQueue->capacity());
+	}
+
+	void Input::update(){
+		if (mBatched)
+			drainMainQueue();
+		if (mParameterAssembler)
+			expireParameters();
+	}
+
+	void Input::drainMainQueue(){
+		// cleared first, so anything pushed from here on schedules another drain
+		mDrainScheduled.store(false, std::memory_order_release);
+
+		// popped into raw storage and copied once, the reserved vector is never zero filled
+		const size_t count = mMainQueue->pop(mDrainBuffer.get(), mMainQueue->capacity());
+		Event *first = mDrainBuffer.get();
+		Event *last = first + count;
+
+		// OVERFLOW_DROP_OLDEST: the producer couldn't drop these itself
+		size_t skip = mDropOldestCount.exchange(0, std::memory_order_relaxed);
+		if (skip > 0){
+			const size_t skipped = skip < count ? skip : count;
+			for (size_t i = 0; i < skipped; ++i)
+				discardMainThread(first[i]);
+			first += skipped;
+			if (skip > skipped)
+				mDropOldestCount.fetch_add(skip - skipped, std::memory_order_relaxed);
+		}
+		if (first == last)
+			return;
+
+		if (mCoalescer){
+			for (Event *event = first; event != last; ++event)
+				if (Coalescer::isCoalescable(*event))
+					*event = mCoalescer->take(*event);
+		}
 
-			msg.port = mPort;
-
-			switch(msg.status) {
-			case MIDI_NOTE_ON :
-			case MIDI_NOTE_OFF:
-				msg.pitch = (int) message->at(1);
-				msg.velocity = (int) message->at(2);
-				break;
-			case MIDI_CONTROL_CHANGE:
-				msg.control = (int) message->at(1);
-				msg.value = (int) message->at(2);
-				break;
-			case MIDI_PROGRAM_CHANGE:
-			case MIDI_AFTERTOUCH:
-				msg.value = (int) message->at(1);
-				break;
-			case MIDI_PITCH_BEND:
-				msg.value = (int) (message->at(2) << 7) +
-					(int) message->at(1); // msb + lsb
-				break;
-			case MIDI_POLY_AFTERTOUCH:
-				msg.pitch = (int) message->at(1);
-				msg.value = (int) message->at(2);
-				break;
-			default:
-				break;
+		// parameter markers keep their place in the drained range, but stay out of the batch
+		mBatch.clear();
+		for (const Event *event = first; event != last; ++event)
+			if (event->status != MIDI_UNKNOWN)
+				mBatch.push_back(*event);
+
+		if (mLatency){
+			for (const Event &event : mBatch)
+				recordMainThreadLatency(event);
+		}
+
+		midiBatchSignal.emit(mBatch);
+		for (const Event *event = first; event != last; ++event){
+			if (event->status == MIDI_UNKNOWN){
+				ParameterEvent parameter;
+				if (takeParameter(*event, &parameter))
+					midiParameterSignal.emit(parameter);
+				continue;
 			}
-        
-            midiThreadSignal.emit( msg );
-        
-            if (mDispatchToMainThread)
-                ci::app::App::get()->dispatchAsync( [this, msg](){ midiSignal.emit( msg ); });
-		}
-
-		// bool Input::hasWaitingMessages(){
-		// 	int queue_length = (int)mMessages.size();
-		// 	return queue_length > 0;
-		// }
-
-		// bool Input::getNextMessage(Message* message){
-		// 	if (mMessages.size() == 0){
-		// 		return false;
-		// 	}
-
-		// 	Message* src_message = mMessages.front();
-		// 	message->copy(*src_message);
-		// 	delete src_message;
-		// 	mMessages.pop_front();
-
-		// 	return true;
-		// }
+			midiEventSignal.emit(*event);
+			if (midiSignal.getNumSlots() > 0)
+				midiSignal.emit(Message(*event));
+			if (!midiHandlers.empty())
+				midiHandlers.dispatch(*event);
+		}
+		for (const Event &event : mBatch)
+			releaseSysex(event);
+	}
+
+	uint64_t Input::getNowNanos(){
+		return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	uint64_t Input::getTimestampNanos(const Event &event) const{
+		// the 32 bit microsecond offset wraps every ~71 minutes, so unwrap it against the current time
+		const uint64_t nowMicros = (getNowNanos() - mEpochNanos) / 1000;
+		const uint32_t age = (uint32_t) nowMicros - event.time;
+		return mEpochNanos + (nowMicros - age) * 1000;
+	}
+
+	double Input::toAppTime(uint64_t nanos) const{
+		return mEpochAppSeconds + (double) ((int64_t) (nanos - mEpochNanos)) * 1.0e-9;
+	}
+
+	void Input::setFilter(const Filter &filter){
+		std::lock_guard<std::mutex> lock(mFilterMutex);
+		// odd sequence numbers tell the midi thread a write is in progress, so it never applies half a filter
+		const uint32_t sequence = mFilterSequence.load(std::memory_order_relaxed);
+		mFilterSequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		mFilterChannels.store(filter.channels, std::memory_order_relaxed);
+		mFilterStatuses.store(filter.statuses, std::memory_order_relaxed);
+		mFilterControllers[0].store(filter.controllers[0], std::memory_order_relaxed);
+		mFilterControllers[1].store(filter.controllers[1], std::memory_order_relaxed);
+		mFilterEnabled.store(true, std::memory_order_relaxed);
+		mFilterSequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	void Input::clearFilter(){
+		std::lock_guard<std::mutex> lock(mFilterMutex);
+		mFilterEnabled.store(false, std::memory_order_relaxed);
+	}
+
+	Filter Input::getFilter() const{
+		Filter filter;
+		readFilter(filter);
+		return filter;
+	}
+
+	bool Input::readFilter(Filter &filter) const{
+		uint32_t begin, end;
+		bool enabled = false;
+		do {
+			begin = mFilterSequence.load(std::memory_order_acquire);
+			if (begin & 1)
+				continue;
+			filter.channels = mFilterChannels.load(std::memory_order_relaxed);
+			filter.statuses = mFilterStatuses.load(std::memory_order_relaxed);
+			filter.controllers[0] = mFilterControllers[0].load(std::memory_order_relaxed);
+			filter.controllers[1] = mFilterControllers[1].load(std::memory_order_relaxed);
+			enabled = mFilterEnabled.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			end = mFilterSequence.load(std::memory_order_relaxed);
+		} while ((begin & 1) || begin != end);
+		return enabled;
+	}
+
+	bool Input::passesFilter(const Event &event) const{
+		// evaluated on a consistent copy so the filter can change while the port is open
+		Filter filter;
+		return !readFilter(filter) || filter.accepts(event);
+	}
+
+	void Input::setSysexPool(size_t slotCount, size_t slotSize){
+		mSysexPool.reset(new SysexPool(slotCount, slotSize));
+	}
+
+	const uint8_t* Input::getSysexData(const Event &event) const{
+		return event.status == MIDI_SYSEX ? mSysexPool->getData(event.getSysexHandle()) : nullptr;
+	}
+
+	size_t Input::getSysexSize(const Event &event) const{
+		return event.status == MIDI_SYSEX ? mSysexPool->getSize(event.getSysexHandle()) : 0;
+	}
+
+	void Input::retainSysex(const Event &event){
+		if (event.status == MIDI_SYSEX)
+			mSysexPool->retain(event.getSysexHandle());
+	}
+
+	void Input::releaseSysex(const Event &event){
+		if (event.status == MIDI_SYSEX)
+			mSysexPool->release(event.getSysexHandle());
+	}
+
+	void Input::setCoalescing(bool coalesce){
+		if (coalesce)
+			mCoalescer.reset(new Coalescer());
+		else
+			mCoalescer.reset();
+	}
+
+	void Input::resetQueueStats(){
+		mQueueHighWaterMark.store(0, std::memory_order_relaxed);
+		mQueueEnqueuedCount.store(0, std::memory_order_relaxed);
+		mQueueOverflowCount.store(0, std::memory_order_relaxed);
+		mPollOverflowCount.store(0, std::memory_order_relaxed);
+		if (mCoalescer)
+			mCoalescer->resetStats();
+	}
+
+	void Input::setPollingEnabled(bool enabled, size_t capacity){
+		if (!enabled){
+			mPollQueue.reset();
+			return;
+		}
+
+		mPollQueue.reset(new RingBuffer<Event>(capacity));
+	}
+
+	size_t Input::poll(Event *out, size_t max){
+		if (!mPollQueue)
+			return 0;
+
+		return mPollQueue->pop(out, max);
+	}
+
+	bool Input::hasWaitingMessages() const{
+		return mPollQueue && !mPollQueue->empty();
+	}
+
+	bool Input::getNextMessage(Message *message){
+		// the previous sysex stays readable until the caller asks for the next message
+		releaseSysex(mPolledSysex);
+		mPolledSysex = Event();
+
+		Event event;
+		if (poll(&event, 1) == 0)
+			return false;
+
+		*message = Message(event);
+		if (event.status == MIDI_SYSEX)
+			mPolledSysex = event;
+		return true;
+	}
 
 		unsigned int Input::getPort()const{
 			return mPort;
@@ -0,0 +1,93 @@
+//
+//  MidiLatency.cpp
+//
+//  See licence and credits in MidiLatency.h.
+//
+
+#include "MidiLatency.h"
+
+namespace cinder { namespace midi {
+
+	namespace {
+		inline int log2Floor( uint64_t v ) {
+			int e = 0;
+			for( int shift = 32; shift > 0; shift >>= 1 ) {
+				if( v >> shift ) {
+					v >>= shift;
+					e += shift;
+				}
+			}
+			return e;
+		}
+	}
+
+	LatencyHistogram::LatencyHistogram(){
+		reset();
+	}
+
+	size_t LatencyHistogram::bucketIndex( uint64_t nanos ){
+		if( nanos < 16 )
+			return (size_t) nanos;
+
+		// exponent picks the power of two, the next 3 bits the linear sub-bucket
+		const int e = log2Floor( nanos );
+		const size_t sub = (size_t) ( nanos >> ( e - 3 ) ) & 7;
+		return 16 + (size_t) ( e - 4 ) * 8 + sub;
+	}
+
+	uint64_t LatencyHistogram::bucketUpperBound( size_t index ){
+		if( index < 16 )
+			return index;
+
+		const int e = (int) ( ( index - 16 ) / 8 ) + 4;
+		const uint64_t sub = ( index - 16 ) % 8;
+		return ( ( 8 + sub + 1 ) << ( e - 3 ) ) - 1;
+	}
+
+	void LatencyHistogram::record( uint64_t nanos ){
+		mBuckets[bucketIndex( nanos )].fetch_add( 1, std::memory_order_relaxed );
+		mCount.fetch_add( 1, std::memory_order_relaxed );
+		mSum.fetch_add( nanos, std::memory_order_relaxed );
+
+		uint64_t max = mMax.load( std::memory_order_relaxed );
+		while( nanos > max && !mMax.compare_exchange_weak( max, nanos, std::memory_order_relaxed ) )
+			;
+	}
+
+	void LatencyHistogram::reset(){
+		for( std::atomic<uint64_t> &bucket : mBuckets )
+			bucket.store( 0, std::memory_order_relaxed );
+		mCount.store( 0, std::memory_order_relaxed );
+		mSum.store( 0, std::memory_order_relaxed );
+		mMax.store( 0, std::memory_order_relaxed );
+	}
+
+	double LatencyHistogram::getMean() const{
+		const uint64_t count = getCount();
+		return count ? (double) mSum.load( std::memory_order_relaxed ) / (double) count : 0.0;
+	}
+
+	uint64_t LatencyHistogram::getPercentile( double percentile ) const{
+		const uint64_t count = getCount();
+		if( count == 0 )
+			return 0;
+
+		uint64_t rank = (uint64_t) ( percentile / 100.0 * (double) count + 0.5 );
+		if( rank < 1 )
+			rank = 1;
+
+		uint64_t seen = 0;
+		for( size_t i = 0; i < BUCKET_COUNT; ++i ) {
+			seen += mBuckets[i].load( std::memory_order_relaxed );
+			if( seen >= rank ) {
+				// never report more than was actually observed
+				const uint64_t bound = bucketUpperBound( i );
+				const uint64_t max = getMax();
+				return bound < max ? bound : max;
+			}
+		}
+		return getMax();
+	}
+
+}// namespace midi
+}// namespace cinder
@@ -11,19 +11,86 @@
 
 namespace cinder { namespace midi {
 	
-	Message::Message(){
+	Message::Message()
+		: port(0), channel(0), status(0), byteOne(0), byteTwo(0), timeStamp(0.0),
+		pitch(0), velocity(0), control(0), value(0){
 	
 	}
 	
+	Message::Message(const Event& event)
+		: port(event.port), channel(event.getChannel()), status(event.getStatus()),
+		byteOne(event.data1), byteTwo(event.data2), timeStamp(event.time * 0.000001),
+		pitch(0), velocity(0), control(0), value(0){
+		
+		switch(status) {
+		case MIDI_NOTE_ON:
+		case MIDI_NOTE_OFF:
+			pitch = event.getPitch();
+			velocity = event.getVelocity();
+			break;
+		case MIDI_CONTROL_CHANGE:
+			control = event.getControl();
+			value = event.getValue();
+			break;
+		case MIDI_POLY_AFTERTOUCH:
+			pitch = event.getPitch();
+			value = event.getValue();
+			break;
+		default:
+			value = event.getValue();
+			break;
+		}
+	}
+	
 	Message& Message::copy(const Message& other){
 		port = other.port;
 		channel = other.channel;
 		status = other.status;
 		byteOne = other.byteOne;
 		byteTwo = other.byteTwo;
+		timeStamp = other.timeStamp;
+		pitch = other.pitch;
+		velocity = other.velocity;
+		control = other.control;
+		value = other.value;
 		
 		return *this;
 	}
+	
+	Event Message::toEvent() const{
+		uint8_t statusByte = (uint8_t) status;
+		if (status >= MIDI_NOTE_OFF && status < MIDI_SYSEX)
+			statusByte = (uint8_t) (status | ((channel - 1) & 0x0F));
+		
+		Event event(statusByte, (uint8_t) byteOne, (uint8_t) byteTwo, (uint8_t) port, (uint32_t) (timeStamp * 1000000.0));
+		switch(status) {
+		case MIDI_NOTE_ON:
+		case MIDI_NOTE_OFF:
+			event.data1 = (uint8_t) (pitch & 0x7F);
+			event.data2 = (uint8_t) (velocity & 0x7F);
+			break;
+		case MIDI_CONTROL_CHANGE:
+			event.data1 = (uint8_t) (control & 0x7F);
+			event.data2 = (uint8_t) (value & 0x7F);
+			break;
+		case MIDI_POLY_AFTERTOUCH:
+			event.data1 = (uint8_t) (pitch & 0x7F);
+			event.data2 = (uint8_t) (value & 0x7F);
+			break;
+		case MIDI_PROGRAM_CHANGE:
+		case MIDI_AFTERTOUCH:
+			event.data1 = (uint8_t) (value & 0x7F);
+			event.data2 = 0;
+			break;
+		case MIDI_PITCH_BEND:
+			event.data1 = (uint8_t) (value & 0x7F); // lsb
+			event.data2 = (uint8_t) ((value >> 7) & 0x7F); // msb
+			break;
+		default:
+			break;
+		}
+		return event;
+	}
 
 }// namespace midi
 }// namespace cinder
\ No newline at end of file
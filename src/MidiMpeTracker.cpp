@@ -0,0 +1,215 @@
+//
+//  MidiMpeTracker.cpp
+//
+//  See licence and credits in MidiMpeTracker.h.
+//
+
+#include "MidiMpeTracker.h"
+
+namespace cinder { namespace midi {
+
+	float MpeSnapshot::getPitch( const MpeVoice &voice ) const{
+		float pitch = voice.note;
+		const MpeZone *zone = nullptr;
+		bool isManager = false;
+		if( lowerZone.memberChannels && voice.channel <= 1 + lowerZone.memberChannels ){
+			zone = &lowerZone;
+			isManager = voice.channel == 1;
+		}
+		else if( upperZone.memberChannels && voice.channel >= 16 - upperZone.memberChannels ){
+			zone = &upperZone;
+			isManager = voice.channel == 16;
+		}
+
+		if( zone ){
+			pitch += ( voice.pitchBend - 8192 ) / 8192.0f * ( isManager ? zone->managerBendRange : zone->memberBendRange );
+			if( !isManager )
+				pitch += ( zone->managerPitchBend - 8192 ) / 8192.0f * zone->managerBendRange;
+		}
+		else {
+			// outside any zone: plain midi with the general midi default range
+			pitch += ( voice.pitchBend - 8192 ) / 8192.0f * 2.0f;
+		}
+		return pitch;
+	}
+
+	MpeTracker::MpeTracker()
+		: mParameters( 10000 ), mBack( 0 ), mFront( 1 )
+	{
+		mMiddle.store( 2 );
+		for( int ch = 0; ch < 16; ++ch ){
+			mPitchBend[ch] = 8192;
+			mPressure[ch] = 0;
+			mTimbre[ch] = 64;
+		}
+		for( MpeSnapshot &buffer : mBuffers ){
+			buffer.voiceCount = 0;
+			configureZone( buffer.lowerZone, 15 );
+			configureZone( buffer.upperZone, 0 );
+		}
+	}
+
+	void MpeTracker::configureZone( MpeZone &zone, int memberChannels ){
+		// a configuration message resets the zone's bend ranges to the MPE defaults
+		zone.memberChannels = (uint8_t) ( memberChannels < 0 ? 0 : memberChannels > 15 ? 15 : memberChannels );
+		zone.memberBendRange = 48.0f;
+		zone.managerBendRange = 2.0f;
+		zone.managerPitchBend = 8192;
+	}
+
+	void MpeTracker::setZones( int lowerMemberChannels, int upperMemberChannels ){
+		MpeSnapshot &back = mBuffers[mBack];
+		configureZone( back.lowerZone, lowerMemberChannels );
+		configureZone( back.upperZone, upperMemberChannels );
+		// zones can't overlap, the lower one wins
+		if( back.lowerZone.memberChannels + back.upperZone.memberChannels > 14 && back.upperZone.memberChannels )
+			back.upperZone.memberChannels = (uint8_t) ( back.lowerZone.memberChannels >= 14 ? 0 : 14 - back.lowerZone.memberChannels );
+		publish();
+	}
+
+	MpeZone* MpeTracker::getZone( int channel, bool *isManager ){
+		MpeSnapshot &back = mBuffers[mBack];
+		*isManager = false;
+		if( back.lowerZone.memberChannels && channel <= 1 + back.lowerZone.memberChannels ){
+			*isManager = channel == 1;
+			return &back.lowerZone;
+		}
+		if( back.upperZone.memberChannels && channel >= 16 - back.upperZone.memberChannels ){
+			*isManager = channel == 16;
+			return &back.upperZone;
+		}
+		return nullptr;
+	}
+
+	void MpeTracker::onParameter( const ParameterEvent &parameter ){
+		if( parameter.kind != ParameterEvent::RPN )
+			return;
+
+		if( parameter.id == 6 ){
+			// MPE configuration message, only valid on a manager channel. It resets the zone it
+			// addresses; the other zone keeps its settings and only shrinks if they would overlap.
+			if( parameter.channel != 1 && parameter.channel != 16 )
+				return;
+			MpeSnapshot &back = mBuffers[mBack];
+			MpeZone &zone = parameter.channel == 1 ? back.lowerZone : back.upperZone;
+			MpeZone &other = parameter.channel == 1 ? back.upperZone : back.lowerZone;
+			configureZone( zone, parameter.value >> 7 );
+			if( zone.memberChannels + other.memberChannels > 14 && other.memberChannels )
+				other.memberChannels = (uint8_t) ( zone.memberChannels >= 14 ? 0 : 14 - zone.memberChannels );
+			publish();
+			return;
+		}
+
+		if( parameter.id == 0 ){
+			// pitch bend sensitivity: semitones in the MSB, cents in the LSB
+			bool isManager;
+			MpeZone *zone = getZone( parameter.channel, &isManager );
+			if( !zone )
+				return;
+			const float range = ( parameter.value >> 7 ) + ( parameter.value & 0x7F ) / 100.0f;
+			if( isManager )
+				zone->managerBendRange = range;
+			else
+				zone->memberBendRange = range;
+			// readers see the new range now, not with the next expression event
+			publish();
+		}
+	}
+
+	void MpeTracker::noteOn( int channel, int note, int velocity, uint32_t time ){
+		MpeSnapshot &back = mBuffers[mBack];
+		// retrigger of a held note reuses its voice
+		noteOff( channel, note );
+		if( back.voiceCount >= MpeSnapshot::MAX_VOICES )
+			return;
+
+		MpeVoice &voice = back.voices[back.voiceCount++];
+		voice.channel = (uint8_t) channel;
+		voice.note = (uint8_t) note;
+		voice.velocity = (uint8_t) velocity;
+		voice.pressure = mPressure[channel - 1];
+		voice.timbre = mTimbre[channel - 1];
+		voice.pitchBend = mPitchBend[channel - 1];
+		voice.time = time;
+	}
+
+	void MpeTracker::noteOff( int channel, int note ){
+		MpeSnapshot &back = mBuffers[mBack];
+		for( int i = 0; i < back.voiceCount; ++i ){
+			if( back.voices[i].channel == channel && back.voices[i].note == note ){
+				back.voices[i] = back.voices[--back.voiceCount];
+				return;
+			}
+		}
+	}
+
+	void MpeTracker::process( const Event &event ){
+		if( !event.isChannelMessage() )
+			return;
+
+		mParameters.process( event, [this]( const ParameterEvent &parameter ){ onParameter( parameter ); } );
+
+		MpeSnapshot &back = mBuffers[mBack];
+		const int channel = event.getChannel();
+		switch( event.getStatus() ){
+		case MIDI_NOTE_ON:
+			if( event.data2 > 0 )
+				noteOn( channel, event.data1, event.data2, event.time );
+			else
+				noteOff( channel, event.data1 );
+			break;
+		case MIDI_NOTE_OFF:
+			noteOff( channel, event.data1 );
+			break;
+		case MIDI_PITCH_BEND: {
+			mPitchBend[channel - 1] = (uint16_t) event.getValue();
+			bool isManager;
+			MpeZone *zone = getZone( channel, &isManager );
+			if( zone && isManager )
+				zone->managerPitchBend = mPitchBend[channel - 1];
+			for( int i = 0; i < back.voiceCount; ++i )
+				if( back.voices[i].channel == channel )
+					back.voices[i].pitchBend = mPitchBend[channel - 1];
+			break;
+		}
+		case MIDI_AFTERTOUCH:
+			mPressure[channel - 1] = event.data1;
+			for( int i = 0; i < back.voiceCount; ++i )
+				if( back.voices[i].channel == channel )
+					back.voices[i].pressure = event.data1;
+			break;
+		case MIDI_POLY_AFTERTOUCH:
+			for( int i = 0; i < back.voiceCount; ++i )
+				if( back.voices[i].channel == channel && back.voices[i].note == event.data1 )
+					back.voices[i].pressure = event.data2;
+			break;
+		case MIDI_CONTROL_CHANGE:
+			if( event.data1 != 74 )
+				return;
+			mTimbre[channel - 1] = event.data2;
+			for( int i = 0; i < back.voiceCount; ++i )
+				if( back.voices[i].channel == channel )
+					back.voices[i].timbre = event.data2;
+			break;
+		default:
+			return;
+		}
+
+		publish();
+	}
+
+	void MpeTracker::publish(){
+		// hand the filled buffer over and carry on writing into the one we get back
+		const int written = mBack;
+		mBack = mMiddle.exchange( written | FRESH, std::memory_order_acq_rel ) & ~FRESH;
+		mBuffers[mBack] = mBuffers[written];
+	}
+
+	const MpeSnapshot& MpeTracker::read(){
+		if( mMiddle.load( std::memory_order_relaxed ) & FRESH )
+			mFront = mMiddle.exchange( mFront, std::memory_order_acq_rel ) & ~FRESH;
+		return mBuffers[mFront];
+	}
+
+}// namespace midi
+}// namespace cinder
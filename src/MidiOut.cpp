@@ -9,6 +9,7 @@
 #include <vector>
 #include <sstream>
 #include <assert.h>
+#include <algorithm>
 #include "MidiOut.h"
 
 
@@ -24,11 +25,27 @@ MidiOut::MidiOut(std::string const& name)
 //, mRtMidiOut(new RtMidiOut(name))
 , mPortNumber(-1)
 , mIsVirtual(false)
-, mBytes(3)
+, mNoteTracking(false)
+, mBatchDepth(0)
+, mScheduleCapacity(0)
+, mScheduleSequence(0)
+, mStopDispatcher(false)
+, mBlockTimeoutMicros(0)
+, mWriterIdle(false)
+, mStopWriter(false)
+, mOutputEnqueuedCount(0)
+, mOutputWrittenCount(0)
+, mOutputDroppedCount(0)
+, mOutputLagNanos(0)
+, mMaxOutputLagNanos(0)
+, mStopPacer(false)
 {}
 
 MidiOut::~MidiOut()
 {
+	setScheduling(false);
+	setRateLimit(false);
+	setAsyncOutput(false);
 	closePort();
 }
 
@@ -38,10 +55,11 @@ MidiOut::~MidiOut()
 ///		  from the system.
 std::vector<std::string> MidiOut::getPortList() const
 {
+	PortRegistry::get().refresh();
 	vector<string> portList;
-	for(unsigned int i = 0; i < mRtMidiOut->getPortCount(); ++i)
+	for (const PortInfo& port : PortRegistry::get().getOutputs())
 	{
-		portList.push_back(mRtMidiOut->getPortName(i));
+		portList.push_back(port.name);
 	}
 	return portList;
 }
@@ -49,14 +67,15 @@ std::vector<std::string> MidiOut::getPortList() const
 /// Get the number of output ports
 int MidiOut::getNumPorts() const
 {
-		return mRtMidiOut->getPortCount();
+	PortRegistry::get().refresh();
+	return (int)PortRegistry::get().getOutputs().size();
 }
 
 /// Get the name of an output port by it's number
 /// \return "" if number is invalid
 std::string MidiOut::getPortName(unsigned int portNumber) const
 {
-	return mRtMidiOut->getPortName(portNumber).c_str(); // strip null chars introduced by rtmidi
+	return PortRegistry::get().getOutputName(portNumber);
 }
 
 /// \section Connection
@@ -71,6 +90,7 @@ bool MidiOut::openPort(unsigned int portNumber)
 		closePort();
         std::stringstream ss;
         ss << mName << "Output " << portNumber;
+		std::lock_guard<std::mutex> lock(mDriverMutex);
 		mRtMidiOut->openPort( portNumber, ss.str() );
 	}
 	catch (RtMidiError& err)
@@ -79,12 +99,24 @@ bool MidiOut::openPort(unsigned int portNumber)
 		return false;
 	}
 	mPortNumber = portNumber;
-	mPortName = mRtMidiOut->getPortName(portNumber);
+	mPortName = PortRegistry::get().getOutputName(portNumber);
 	if (sVerboseLogging)
 		std::cout << "[VERBOSE ci::midi::MidiOut::openPort] opened port " << portNumber << " " << mPortName << std::endl;
 	return true;
 }
 
+/// Connect to an output port by name, see PortRegistry.
+bool MidiOut::openPort(std::string const& portName)
+{
+	int portNumber = PortRegistry::get().findOutput(portName);
+	if (portNumber < 0)
+	{
+		std::cout << "[ERROR ci::midi::MidiOut::openPort] no output port named " << portName << std::endl;
+		return false;
+	}
+	return openPort((unsigned int)portNumber);
+}
+
 /// Create and connect to a virtual output port (MacOS and Linux ALSA only).
 /// allows for connections between software
 /// note: a connected virtual port has a portNum = -1
@@ -97,6 +129,7 @@ bool MidiOut::openVirtualPort(std::string const& portName)
 	try
 	{
 		closePort();
+		std::lock_guard<std::mutex> lock(mDriverMutex);
 		mRtMidiOut->openVirtualPort(portName);
 	}
 	catch (RtMidiError& err) {
@@ -126,6 +159,21 @@ void MidiOut::closePort()
             std::cout << "[VERBOSE ci::midi::MidiOut::closePort] closed port " << mPortNumber << ": " << mPortName << std::endl;
 		}
 	}
+	// events still waiting would go nowhere, and the notes sent by now must be released below
+	clearSchedule();
+	if (mNoteTracking && isOpen())
+		mActiveNotes.releaseAll([this](const Event& noteOff) { sendMessage(noteOff); });
+	mActiveNotes.reset();
+	if (mRateLimiter)
+		drainRateLimiter();
+	if (mAsyncQueue && isOpen())
+		waitForOutput(100000);
+	std::lock_guard<std::mutex> lock(mDriverMutex);
+	if (mBatchDepth > 0)
+	{
+		mBatchDepth = 0;
+		mRtMidiOut->flushBatch();
+	}
 	mRtMidiOut->closePort();
 	mPortNumber = -1;
 	mPortName = "";
@@ -183,26 +231,479 @@ bool MidiOut::isVirtual() const
 ///
 void MidiOut::sendMessage(unsigned char status, unsigned char byteOne, unsigned char byteTwo)
 {
-	assert(mBytes.size() == 3);
-	mBytes[0] = status;
-	mBytes[1] = byteOne;
-	mBytes[2] = byteTwo;
-	sendMessage(mBytes);
+	const uint8_t bytes[3] = { status, byteOne, byteTwo };
+	sendMessage(bytes, 3);
+	if (mNoteTracking)
+		mActiveNotes.update(Event(status, byteOne, byteTwo));
 }
 
 void MidiOut::sendMessage(unsigned char status, unsigned char byteOne)
 {
-	assert(mBytes.size() == 3);
-	mBytes.resize(2);
-	mBytes[0] = status;
-	mBytes[1] = byteOne;
-	sendMessage(mBytes);
-	mBytes.resize(3); // restore invariant
+	const uint8_t bytes[2] = { status, byteOne };
+	sendMessage(bytes, 2);
+}
+
+void MidiOut::sendMessage(const Event& event)
+{
+	switch (event.getSize())
+	{
+	case 3:
+		sendMessage(event.status, event.data1, event.data2);
+		break;
+	case 2:
+		sendMessage(event.status, event.data1);
+		break;
+	case 1:
+		sendMessage(&event.status, 1);
+		break;
+	default:
+		break;
+	}
+}
+
+void MidiOut::sendBatch(const Event* events, size_t count)
+{
+	beginBatch();
+	for (size_t i = 0; i < count; ++i)
+		sendMessage(events[i]);
+	flush();
+}
+
+void MidiOut::beginBatch()
+{
+	if (mAsyncQueue || mRateLimiter)
+		return;
+	if (mBatchDepth++ == 0)
+		mRtMidiOut->beginBatch();
+}
+
+void MidiOut::flush()
+{
+	if (mBatchDepth == 0 || mAsyncQueue || mRateLimiter)
+		return;
+	if (--mBatchDepth == 0)
+		mRtMidiOut->flushBatch();
+}
+
+void MidiOut::sendMessage(const std::vector<unsigned char>& bytes)
+{
+	if (!bytes.empty())
+		sendMessage(bytes.data(), bytes.size());
+}
+
+void MidiOut::sendMessage(const uint8_t* bytes, size_t size)
+{
+	if (mRateLimiter && size > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mPaceMutex);
+			if (bytes[0] == MIDI_SYSEX || size > 3)
+			{
+				// keeps its place behind the notes already waiting
+				if (!mRateLimiter->pushSysex(size))
+					return;
+				mPacedSysex.emplace_back(bytes, bytes + size);
+			}
+			else if (!mRateLimiter->push(Event(bytes[0], size > 1 ? bytes[1] : 0, size > 2 ? bytes[2] : 0)))
+				return;
+		}
+		mPaceCondition.notify_one();
+		return;
+	}
+	output(bytes, size);
+}
+
+void MidiOut::output(const uint8_t* bytes, size_t size)
+{
+	if (mAsyncQueue)
+		enqueue(bytes, size);
+	else if (mRateLimiter)
+	{
+		// the pacer thread writes too
+		std::lock_guard<std::mutex> lock(mDriverMutex);
+		mRtMidiOut->sendMessage(bytes, size);
+	}
+	else
+		mRtMidiOut->sendMessage(bytes, size);
+}
+
+void MidiOut::output(const Event* events, size_t count)
+{
+	if (mAsyncQueue)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint8_t bytes[3] = { events[i].status, events[i].data1, events[i].data2 };
+			enqueue(bytes, events[i].getSize());
+		}
+		return;
+	}
+	std::lock_guard<std::mutex> lock(mDriverMutex);
+	mRtMidiOut->beginBatch();
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint8_t bytes[3] = { events[i].status, events[i].data1, events[i].data2 };
+		mRtMidiOut->sendMessage(bytes, events[i].getSize());
+	}
+	mRtMidiOut->flushBatch();
+}
+
+/// \section Scheduling
+
+void MidiOut::setScheduling(bool enabled, size_t capacity)
+{
+	if (mDispatcher.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mScheduleMutex);
+			mStopDispatcher = true;
+		}
+		mScheduleCondition.notify_one();
+		mDispatcher.join();
+	}
+	clearSchedule();
+	if (!enabled)
+		return;
+	mSchedule.reserve(capacity);
+	mKernelSchedule.reserve(capacity);
+	mScheduleCapacity = capacity;
+	mStopDispatcher = false;
+	mDispatcher = std::thread(&MidiOut::dispatch, this);
+}
+
+bool MidiOut::sendAt(uint64_t nanos, const Event& event)
+{
+	if (!mDispatcher.joinable() || event.getSize() == 0)
+		return false;
+	
+	{
+		std::lock_guard<std::mutex> lock(mScheduleMutex);
+		retireKernelEvents(Input::getNowNanos());
+		// the ALSA pool runs out long before a large heap would, so both count against capacity
+		if (mSchedule.size() + mKernelSchedule.size() >= mScheduleCapacity)
+			return false;
+		
+		// let the kernel time it when the backend can, the dispatcher then stays idle.
+		// The async writer or the pacer own the driver though, so then the dispatcher feeds them.
+		const uint8_t bytes[3] = { event.status, event.data1, event.data2 };
+		if (!mAsyncQueue && !mRateLimiter && mRtMidiOut->sendMessageAt(bytes, event.getSize(), nanos))
+		{
+			// remembered until due, so clearSchedule() knows what is still pending
+			mKernelSchedule.push_back({ nanos, mScheduleSequence++, event });
+			std::push_heap(mKernelSchedule.begin(), mKernelSchedule.end());
+			return true;
+		}
+		
+		mSchedule.push_back({ nanos, mScheduleSequence++, event });
+		std::push_heap(mSchedule.begin(), mSchedule.end());
+	}
+	mScheduleCondition.notify_one();
+	return true;
 }
 
-void MidiOut::sendMessage(std::vector<unsigned char>& bytes)
+void MidiOut::clearSchedule()
 {
-	mRtMidiOut->sendMessage(&bytes);
+	std::lock_guard<std::mutex> lock(mScheduleMutex);
+	mSchedule.clear();
+	// what is due has reached the device, the rest is taken back out of the ALSA queue
+	retireKernelEvents(Input::getNowNanos());
+	if (!mKernelSchedule.empty())
+	{
+		mKernelSchedule.clear();
+		std::lock_guard<std::mutex> driverLock(mDriverMutex);
+		mRtMidiOut->cancelScheduled();
+	}
+}
+
+size_t MidiOut::getScheduledCount() const
+{
+	const uint64_t now = Input::getNowNanos();
+	std::lock_guard<std::mutex> lock(mScheduleMutex);
+	return mSchedule.size() + std::count_if(mKernelSchedule.begin(), mKernelSchedule.end(),
+		[now](const Scheduled& scheduled) { return scheduled.time > now; });
+}
+
+void MidiOut::retireKernelEvents(uint64_t now)
+{
+	while (!mKernelSchedule.empty() && mKernelSchedule.front().time <= now)
+	{
+		if (mNoteTracking)
+			mActiveNotes.update(mKernelSchedule.front().event);
+		std::pop_heap(mKernelSchedule.begin(), mKernelSchedule.end());
+		mKernelSchedule.pop_back();
+	}
+}
+
+void MidiOut::dispatch()
+{
+	// sleeping is only accurate to a scheduler tick, so wake up early and spin the rest
+	const uint64_t spinNanos = 500000;
+	
+	std::unique_lock<std::mutex> lock(mScheduleMutex);
+	while (!mStopDispatcher)
+	{
+		if (mSchedule.empty())
+		{
+			mScheduleCondition.wait(lock);
+			continue;
+		}
+		uint64_t due = mSchedule.front().time;
+		uint64_t now = Input::getNowNanos();
+		if (due > now + spinNanos)
+		{
+			mScheduleCondition.wait_for(lock, std::chrono::nanoseconds(due - now - spinNanos));
+			continue;
+		}
+		if (due > now)
+		{
+			// an earlier event may arrive meanwhile, so look at the front again afterwards
+			lock.unlock();
+			while (Input::getNowNanos() < due)
+				std::this_thread::yield();
+			lock.lock();
+			continue;
+		}
+		std::pop_heap(mSchedule.begin(), mSchedule.end());
+		Event event = mSchedule.back().event;
+		mSchedule.pop_back();
+		lock.unlock();
+		sendMessage(event);
+		lock.lock();
+	}
+}
+
+/// \section Async output
+
+void MidiOut::setAsyncOutput(bool enabled, size_t capacity, uint32_t blockTimeoutMicros)
+{
+	if (mWriter.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mWakeMutex);
+			mStopWriter = true;
+		}
+		mWakeCondition.notify_one();
+		mWriter.join();
+	}
+	mAsyncQueue.reset();
+	mAsyncSysex.clear();
+	if (!enabled)
+		return;
+	mAsyncQueue.reset(new MpscRingBuffer<Queued>(capacity));
+	mBlockTimeoutMicros = blockTimeoutMicros;
+	mStopWriter = false;
+	mWriter = std::thread(&MidiOut::write, this);
+}
+
+bool MidiOut::enqueue(const uint8_t* bytes, size_t size)
+{
+	if (size == 0)
+		return false;
+	// every MIDI_SYSEX marker must be matched by a payload, however short the sysex
+	const bool payload = bytes[0] == MIDI_SYSEX || size > 3;
+	Queued queued;
+	queued.time = Input::getNowNanos();
+	queued.event = payload ? Event(MIDI_SYSEX) : Event(bytes[0], size > 1 ? bytes[1] : 0, size > 2 ? bytes[2] : 0);
+	auto push = [&]()
+	{
+		if (!payload)
+			return mAsyncQueue->push(queued);
+		// the marker is pushed under the same lock so markers and payloads stay in step
+		std::lock_guard<std::mutex> lock(mSysexMutex);
+		if (!mAsyncQueue->push(queued))
+			return false;
+		mAsyncSysex.emplace_back(bytes, bytes + size);
+		return true;
+	};
+	bool pushed = push();
+	if (!pushed && mBlockTimeoutMicros > 0)
+	{
+		const uint64_t deadline = queued.time + uint64_t(mBlockTimeoutMicros) * 1000;
+		while (!pushed && Input::getNowNanos() < deadline)
+		{
+			std::this_thread::yield();
+			pushed = push();
+		}
+	}
+	if (!pushed)
+	{
+		mOutputDroppedCount.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	mOutputEnqueuedCount.fetch_add(1, std::memory_order_relaxed);
+	
+	// only an idle writer needs waking. Notifying without the lock keeps producers lock-free;
+	// a wakeup lost between the writer's last look and its wait costs at most the 10 ms timeout.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (mWriterIdle.load())
+		mWakeCondition.notify_one();
+	return true;
+}
+
+void MidiOut::write()
+{
+	const size_t maxBatch = 64;
+	Queued batch[maxBatch];
+	std::vector<uint8_t> sysex;
+	for (;;)
+	{
+		size_t count = 0;
+		while (count < maxBatch && mAsyncQueue->pop(batch[count]))
+			++count;
+		if (count == 0)
+		{
+			std::unique_lock<std::mutex> lock(mWakeMutex);
+			if (mStopWriter && mAsyncQueue->empty())
+				break;
+			mWriterIdle = true;
+			if (mAsyncQueue->empty() && !mStopWriter)
+				mWakeCondition.wait_for(lock, std::chrono::milliseconds(10));
+			mWriterIdle = false;
+			continue;
+		}
+		
+		uint64_t lag = 0;
+		{
+			std::lock_guard<std::mutex> lock(mDriverMutex);
+			mRtMidiOut->beginBatch();
+			for (size_t i = 0; i < count; ++i)
+			{
+				const Event& event = batch[i].event;
+				if (event.status == MIDI_SYSEX)
+				{
+					{
+						std::lock_guard<std::mutex> sysexLock(mSysexMutex);
+						sysex.swap(mAsyncSysex.front());
+						mAsyncSysex.pop_front();
+					}
+					mRtMidiOut->sendMessage(sysex.data(), sysex.size());
+				}
+				else
+				{
+					const uint8_t bytes[3] = { event.status, event.data1, event.data2 };
+					mRtMidiOut->sendMessage(bytes, event.getSize());
+				}
+			}
+			mRtMidiOut->flushBatch();
+			// the oldest event of the batch waited longest
+			lag = Input::getNowNanos() - batch[0].time;
+		}
+		mOutputLagNanos.store(lag, std::memory_order_relaxed);
+		if (lag > mMaxOutputLagNanos.load(std::memory_order_relaxed))
+			mMaxOutputLagNanos.store(lag, std::memory_order_relaxed);
+		mOutputWrittenCount.fetch_add(count, std::memory_order_release);
+	}
+}
+
+bool MidiOut::waitForOutput(uint32_t timeoutMicros)
+{
+	if (!mAsyncQueue)
+		return true;
+	const uint64_t target = mOutputEnqueuedCount.load(std::memory_order_acquire);
+	const uint64_t deadline = Input::getNowNanos() + uint64_t(timeoutMicros) * 1000;
+	while (mOutputWrittenCount.load(std::memory_order_acquire) < target)
+	{
+		if (Input::getNowNanos() >= deadline)
+			return false;
+		std::this_thread::sleep_for(std::chrono::microseconds(50));
+	}
+	return true;
+}
+
+void MidiOut::resetOutputStats()
+{
+	// the enqueued and written counts pace waitForOutput(), so they keep running
+	mOutputDroppedCount = 0;
+	mOutputLagNanos = 0;
+	mMaxOutputLagNanos = 0;
+}
+
+/// \section Rate limiting
+
+void MidiOut::setRateLimit(bool enabled, double bytesPerSecond, size_t queueCapacity)
+{
+	if (mPacer.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mPaceMutex);
+			mStopPacer = true;
+		}
+		mPaceCondition.notify_one();
+		mPacer.join();
+	}
+	if (mRateLimiter)
+	{
+		drainRateLimiter();
+		mRateLimiter.reset();
+	}
+	if (!enabled)
+		return;
+	mRateLimiter.reset(new RateLimiter(bytesPerSecond, 32.0, queueCapacity));
+	mStopPacer = false;
+	mPacer = std::thread(&MidiOut::pace, this);
+}
+
+void MidiOut::pace()
+{
+	const size_t maxBatch = 64;
+	Event batch[maxBatch];
+	std::deque<std::vector<uint8_t>> sysex;
+	std::unique_lock<std::mutex> lock(mPaceMutex);
+	while (!mStopPacer)
+	{
+		const uint64_t now = Input::getNowNanos();
+		size_t count = mRateLimiter->pump(now, batch, maxBatch);
+		if (count > 0)
+		{
+			// take the payloads of the placeholders pumped, they leave in the same order
+			for (size_t i = 0; i < count; ++i)
+			{
+				if (batch[i].status == MIDI_SYSEX)
+				{
+					sysex.push_back(std::move(mPacedSysex.front()));
+					mPacedSysex.pop_front();
+				}
+			}
+			lock.unlock();
+			outputPaced(batch, count, sysex);
+			lock.lock();
+			continue;
+		}
+		const uint64_t wait = mRateLimiter->getWaitNanos(now);
+		if (wait == UINT64_MAX)
+			mPaceCondition.wait(lock);
+		else
+			mPaceCondition.wait_for(lock, std::chrono::nanoseconds(wait));
+	}
+}
+
+void MidiOut::drainRateLimiter()
+{
+	// over budget, but nothing may be left behind when the port goes away
+	const size_t maxBatch = 64;
+	Event batch[maxBatch];
+	std::lock_guard<std::mutex> lock(mPaceMutex);
+	while (size_t count = mRateLimiter->takeAll(batch, maxBatch))
+		outputPaced(batch, count, mPacedSysex);
+	mRateLimiter->reset();
+	mPacedSysex.clear();
+}
+
+void MidiOut::outputPaced(const Event* events, size_t count, std::deque<std::vector<uint8_t>>& sysex)
+{
+	size_t begin = 0;
+	for (size_t i = 0; i < count; ++i)
+	{
+		if (events[i].status != MIDI_SYSEX)
+			continue;
+		if (i > begin)
+			output(events + begin, i - begin);
+		output(sysex.front().data(), sysex.front().size());
+		sysex.pop_front();
+		begin = i + 1;
+	}
+	if (count > begin)
+		output(events + begin, count - begin);
 }
 
 void MidiOut::sendNoteOn(int channel, int pitch, int velocity)
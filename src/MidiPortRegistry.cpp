@@ -0,0 +1,144 @@
+//
+//  MidiPortRegistry.cpp
+//
+//  See licence and credits in MidiPortRegistry.h.
+//
+
+#include <chrono>
+
+#include "MidiPortRegistry.h"
+
+namespace cinder { namespace midi {
+
+	PortRegistry& PortRegistry::get(){
+		static PortRegistry sRegistry;
+		return sRegistry;
+	}
+
+	PortRegistry::PortRegistry()
+		: mGeneration( 0 ), mEnumerated( false )
+	{
+	}
+
+	std::string PortRegistry::makeId( RtMidi::Api backend, const std::string &name ){
+		// RtMidi's ALSA names end in the sequencer address, which stays put while the port lives
+		if( backend == RtMidi::LINUX_ALSA ){
+			const size_t space = name.find_last_of( ' ' );
+			const std::string address = name.substr( space == std::string::npos ? 0 : space + 1 );
+			const size_t colon = address.find( ':' );
+			if( colon != std::string::npos && colon > 0 && colon + 1 < address.size()
+				&& address.find_first_not_of( "0123456789:" ) == std::string::npos )
+				return address;
+		}
+		return name;
+	}
+
+	void PortRegistry::enumerate( RtMidi &api, RtMidi::Api backend, std::vector<PortInfo> &ports ){
+		ports.clear();
+		const unsigned int count = api.getPortCount();
+		for( unsigned int i = 0; i < count; ++i ){
+			PortInfo info;
+			info.index = i;
+			info.name = api.getPortName( i ).c_str(); // strip null chars introduced by rtmidi
+			info.id = makeId( backend, info.name );
+			ports.push_back( info );
+		}
+	}
+
+	void PortRegistry::buildIndex( const std::vector<PortInfo> &ports, std::unordered_map<std::string, unsigned int> &index ){
+		index.clear();
+		// with duplicate names the first port wins, as it would for a linear search
+		for( const PortInfo &info : ports )
+			index.insert( std::make_pair( info.name, info.index ) );
+	}
+
+	bool PortRegistry::refresh( bool force ){
+		std::lock_guard<std::mutex> lock( mMutex );
+		if( force || !mEnumerated ){
+			enumerateLocked();
+			return true;
+		}
+
+		// the counts are a cheap walk, names cost a full walk per port; a device swapped for
+		// another keeps the counts though, so compare the names too, but only now and then
+		const bool countsChanged = mIn.getPortCount() != mInputs.size() || mOut.getPortCount() != mOutputs.size();
+		const auto now = std::chrono::steady_clock::now();
+		if( !countsChanged && now - mLastCompare < std::chrono::seconds( 1 ) )
+			return false;
+		mLastCompare = now;
+
+		std::vector<PortInfo> inputs, outputs;
+		enumerate( mIn, mIn.getCurrentApi(), inputs );
+		enumerate( mOut, mOut.getCurrentApi(), outputs );
+		if( inputs == mInputs && outputs == mOutputs )
+			return false;
+
+		mInputs.swap( inputs );
+		mOutputs.swap( outputs );
+		buildIndex( mInputs, mInputIndex );
+		buildIndex( mOutputs, mOutputIndex );
+		++mGeneration;
+		return true;
+	}
+
+	void PortRegistry::enumerateLocked(){
+		mLastCompare = std::chrono::steady_clock::now();
+		enumerate( mIn, mIn.getCurrentApi(), mInputs );
+		enumerate( mOut, mOut.getCurrentApi(), mOutputs );
+		buildIndex( mInputs, mInputIndex );
+		buildIndex( mOutputs, mOutputIndex );
+		mEnumerated = true;
+		++mGeneration;
+	}
+
+	uint32_t PortRegistry::getGeneration() const{
+		std::lock_guard<std::mutex> lock( mMutex );
+		return mGeneration;
+	}
+
+	std::vector<PortInfo> PortRegistry::getInputs(){
+		std::lock_guard<std::mutex> lock( mMutex );
+		if( !mEnumerated )
+			enumerateLocked();
+		return mInputs;
+	}
+
+	std::vector<PortInfo> PortRegistry::getOutputs(){
+		std::lock_guard<std::mutex> lock( mMutex );
+		if( !mEnumerated )
+			enumerateLocked();
+		return mOutputs;
+	}
+
+	int PortRegistry::findInput( const std::string &name ){
+		std::lock_guard<std::mutex> lock( mMutex );
+		if( !mEnumerated )
+			enumerateLocked();
+		auto it = mInputIndex.find( name );
+		return it != mInputIndex.end() ? (int) it->second : -1;
+	}
+
+	int PortRegistry::findOutput( const std::string &name ){
+		std::lock_guard<std::mutex> lock( mMutex );
+		if( !mEnumerated )
+			enumerateLocked();
+		auto it = mOutputIndex.find( name );
+		return it != mOutputIndex.end() ? (int) it->second : -1;
+	}
+
+	std::string PortRegistry::getInputName( unsigned int index ){
+		std::lock_guard<std::mutex> lock( mMutex );
+		if( !mEnumerated )
+			enumerateLocked();
+		return index < mInputs.size() ? mInputs[index].name : std::string();
+	}
+
+	std::string PortRegistry::getOutputName( unsigned int index ){
+		std::lock_guard<std::mutex> lock( mMutex );
+		if( !mEnumerated )
+			enumerateLocked();
+		return index < mOutputs.size() ? mOutputs[index].name : std::string();
+	}
+
+}// namespace midi
+}// namespace cinder
@@ -0,0 +1,230 @@
+//
+//  MidiRateLimiter.cpp
+//
+//  See licence and credits in MidiRateLimiter.h.
+//
+
+#include <algorithm>
+#include <cstring>
+
+#include "MidiRateLimiter.h"
+#include "MidiActiveNotes.h"
+
+namespace cinder { namespace midi {
+
+	namespace {
+		inline bool sameValue( const Event &a, const Event &b ) {
+			return a.status == b.status && a.data1 == b.data1 && a.data2 == b.data2;
+		}
+	}
+
+	RateLimiter::RateLimiter( double bytesPerSecond, double burstBytes, size_t queueCapacity )
+		: mLastRefill( 0 ), mQueue( new Queued[std::max<size_t>( queueCapacity, 1 )] ),
+		mQueueCapacity( std::max<size_t>( queueCapacity, 1 ) ), mQueueHead( 0 ), mQueueCount( 0 ),
+		mPendingCount( 0 ), mCursor( 0 )
+	{
+		setBudget( bytesPerSecond, burstBytes );
+		reset();
+		mThinnedCount.store( 0 );
+		mSuppressedCount.store( 0 );
+		mDroppedCount.store( 0 );
+	}
+
+	void RateLimiter::setBudget( double bytesPerSecond, double burstBytes ){
+		mBytesPerSecond = std::max( bytesPerSecond, 1.0 );
+		// a burst must hold at least one three byte message or nothing is ever sent
+		mBurstBytes = std::max( burstBytes, 3.0 );
+	}
+
+	bool RateLimiter::isThinnable( const Event &event ){
+		switch( event.getStatus() ){
+		case MIDI_PITCH_BEND:
+		case MIDI_AFTERTOUCH:
+			return true;
+		case MIDI_CONTROL_CHANGE:
+			switch( event.data1 ){
+			case 0: case 32:					// bank select, must precede its program change
+			case 6: case 38: case 96: case 97:	// data entry
+			case 98: case 99: case 100: case 101:	// NRPN / RPN numbers
+				return false;
+			default:
+				// pedals and switches (64 - 69) and channel mode messages (120 - 127)
+				return !( event.data1 >= 64 && event.data1 <= 69 ) && event.data1 < 120;
+			}
+		default:
+			return false;
+		}
+	}
+
+	int RateLimiter::slotIndex( const Event &event ){
+		int base = ( event.getChannel() - 1 ) * kSlotsPerChannel;
+		switch( event.getStatus() ){
+		case MIDI_PITCH_BEND:
+			return base + 128;
+		case MIDI_AFTERTOUCH:
+			return base + 129;
+		default:
+			return base + ( event.data1 & 0x7F );
+		}
+	}
+
+	bool RateLimiter::push( const Event &event ){
+		if( !isThinnable( event ) )
+			return enqueue( event, event.getSize() );
+
+		const int index = slotIndex( event );
+		Slot &slot = mSlots[index];
+		const bool isPending = ( mPendingBits[index >> 6] >> ( index & 63 ) ) & 1;
+		if( slot.hasSent && sameValue( slot.sent, event ) ){
+			// back at the value the device already has, whatever was pending is moot
+			if( isPending ){
+				clearPending( index );
+				mThinnedCount.fetch_add( 1, std::memory_order_relaxed );
+			}
+			mSuppressedCount.fetch_add( 1, std::memory_order_relaxed );
+			return false;
+		}
+		slot.pending = event;
+		if( isPending )
+			mThinnedCount.fetch_add( 1, std::memory_order_relaxed );
+		else {
+			mPendingBits[index >> 6] |= uint64_t( 1 ) << ( index & 63 );
+			++mPendingCount;
+		}
+		return true;
+	}
+
+	bool RateLimiter::pushSysex( size_t bytes ){
+		return enqueue( Event( MIDI_SYSEX ), bytes );
+	}
+
+	bool RateLimiter::enqueue( const Event &event, size_t bytes ){
+		if( mQueueCount == mQueueCapacity ){
+			mDroppedCount.fetch_add( 1, std::memory_order_relaxed );
+			return false;
+		}
+		Queued &queued = mQueue[( mQueueHead + mQueueCount ) % mQueueCapacity];
+		queued.event = event;
+		queued.bytes = bytes;
+		++mQueueCount;
+		return true;
+	}
+
+	void RateLimiter::popFront(){
+		mQueueHead = ( mQueueHead + 1 ) % mQueueCapacity;
+		--mQueueCount;
+	}
+
+	void RateLimiter::refill( uint64_t nowNanos ){
+		if( nowNanos > mLastRefill ){
+			mTokens = std::min( mBurstBytes, mTokens + ( nowNanos - mLastRefill ) * 1e-9 * mBytesPerSecond );
+			mLastRefill = nowNanos;
+		}
+	}
+
+	int RateLimiter::nextPending() const {
+		if( mPendingCount == 0 )
+			return -1;
+		// scan the bitmap from the cursor, wrapping around once
+		for( int step = 0; step <= kWordCount; ++step ){
+			const int word = ( ( mCursor >> 6 ) + step ) % kWordCount;
+			uint64_t bits = mPendingBits[word];
+			if( step == 0 )
+				bits &= ~uint64_t( 0 ) << ( mCursor & 63 );
+			if( bits )
+				return word * 64 + ActiveNotes::countTrailingZeros( bits );
+		}
+		return -1;
+	}
+
+	void RateLimiter::clearPending( int index ){
+		mPendingBits[index >> 6] &= ~( uint64_t( 1 ) << ( index & 63 ) );
+		--mPendingCount;
+	}
+
+	size_t RateLimiter::pump( uint64_t nowNanos, Event *out, size_t max ){
+		refill( nowNanos );
+		size_t count = 0;
+		// notes first; a note waiting for budget holds back the controllers as well.
+		// a sysex larger than the burst goes out once the bucket is full and runs it into debt
+		while( count < max && mQueueCount > 0 ){
+			const Queued &queued = front();
+			if( mTokens < std::min( (double)queued.bytes, mBurstBytes ) )
+				return count;
+			mTokens -= (double)queued.bytes;
+			out[count++] = queued.event;
+			popFront();
+		}
+		while( count < max ){
+			const int index = nextPending();
+			if( index < 0 )
+				break;
+			Slot &slot = mSlots[index];
+			if( mTokens < (double)slot.pending.getSize() )
+				break;
+			mTokens -= (double)slot.pending.getSize();
+			out[count++] = slot.pending;
+			slot.sent = slot.pending;
+			slot.hasSent = true;
+			clearPending( index );
+			mCursor = ( index + 1 ) % kSlotCount;
+		}
+		return count;
+	}
+
+	size_t RateLimiter::takeAll( Event *out, size_t max ){
+		size_t count = 0;
+		while( count < max && mQueueCount > 0 ){
+			out[count++] = front().event;
+			popFront();
+		}
+		while( count < max ){
+			const int index = nextPending();
+			if( index < 0 )
+				break;
+			Slot &slot = mSlots[index];
+			out[count++] = slot.pending;
+			slot.sent = slot.pending;
+			slot.hasSent = true;
+			clearPending( index );
+			mCursor = ( index + 1 ) % kSlotCount;
+		}
+		return count;
+	}
+
+	uint64_t RateLimiter::getWaitNanos( uint64_t nowNanos ) const {
+		double size;
+		if( mQueueCount > 0 )
+			size = std::min( (double)front().bytes, mBurstBytes );
+		else {
+			const int index = nextPending();
+			if( index < 0 )
+				return UINT64_MAX;
+			size = (double)mSlots[index].pending.getSize();
+		}
+		double tokens = mTokens;
+		if( nowNanos > mLastRefill )
+			tokens = std::min( mBurstBytes, tokens + ( nowNanos - mLastRefill ) * 1e-9 * mBytesPerSecond );
+		if( tokens >= size )
+			return 0;
+		return (uint64_t)( ( size - tokens ) / mBytesPerSecond * 1e9 ) + 1;
+	}
+
+	void RateLimiter::reset(){
+		mTokens = mBurstBytes;
+		mQueueHead = 0;
+		mQueueCount = 0;
+		std::memset( mSlots, 0, sizeof( mSlots ) );
+		std::memset( mPendingBits, 0, sizeof( mPendingBits ) );
+		mPendingCount = 0;
+		mCursor = 0;
+	}
+
+	void RateLimiter::resetStats(){
+		mThinnedCount.store( 0, std::memory_order_relaxed );
+		mSuppressedCount.store( 0, std::memory_order_relaxed );
+		mDroppedCount.store( 0, std::memory_order_relaxed );
+	}
+
+}// namespace midi
+}// namespace cinder
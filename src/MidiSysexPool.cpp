@@ -0,0 +1,68 @@
+//
+//  MidiSysexPool.cpp
+//
+//  See licence and credits in MidiSysexPool.h.
+//
+
+#include <cassert>
+#include <cstring>
+
+#include "MidiSysexPool.h"
+
+namespace cinder { namespace midi {
+
+	SysexPool::SysexPool( size_t slotCount, size_t slotSize )
+		: mSlotCount( slotCount < MAX_SLOTS ? slotCount : MAX_SLOTS ), mSlots( new Slot[mSlotCount] )
+	{
+		for( size_t i = 0; i < mSlotCount; ++i )
+			mSlots[i].bytes.resize( slotSize );
+	}
+
+	int SysexPool::store( const uint8_t *data, size_t size ){
+		for( size_t n = 0; n < mSlotCount; ++n ){
+			size_t index = ( mNextSlot + n ) % mSlotCount;
+			Slot &slot = mSlots[index];
+			if( slot.refs.load( std::memory_order_acquire ) != 0 )
+				continue;
+
+			// only a dump larger than any before allocates, the buffer is kept for reuse
+			if( slot.bytes.size() < size )
+				slot.bytes.resize( size );
+			std::memcpy( slot.bytes.data(), data, size );
+			slot.size = size;
+			slot.refs.store( 1, std::memory_order_release );
+
+			mNextSlot = index + 1;
+			return (int) index;
+		}
+
+		mDroppedCount.fetch_add( 1, std::memory_order_relaxed );
+		return INVALID_HANDLE;
+	}
+
+	void SysexPool::retain( int handle ){
+		if( isValid( handle ) )
+			mSlots[handle].refs.fetch_add( 1, std::memory_order_relaxed );
+	}
+
+	void SysexPool::release( int handle ){
+		if( ! isValid( handle ) )
+			return;
+		// a stray second release must not push the count below zero, the slot would never be reused again
+		std::atomic<int> &refs = mSlots[handle].refs;
+		int count = refs.load( std::memory_order_relaxed );
+		while( count > 0 && ! refs.compare_exchange_weak( count, count - 1, std::memory_order_acq_rel, std::memory_order_relaxed ) )
+			;
+		assert( count > 0 && "sysex slot released more often than retained" );
+	}
+
+	const uint8_t* SysexPool::getData( int handle ) const{
+		return isValid( handle ) ? mSlots[handle].bytes.data() : nullptr;
+	}
+
+	size_t SysexPool::getSize( int handle ) const{
+		return isValid( handle ) ? mSlots[handle].size : 0;
+	}
+
+}// namespace midi
+}// namespace cinder
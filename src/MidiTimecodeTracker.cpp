@@ -0,0 +1,179 @@
+//
+//  MidiTimecodeTracker.cpp
+//
+//  See licence and credits in MidiTimecodeTracker.h.
+//
+
+#include "MidiTimecodeTracker.h"
+
+namespace cinder { namespace midi {
+
+	namespace {
+		const uint8_t FLAG_VALID	= 0x04;
+		const uint8_t FLAG_RUNNING	= 0x08;
+
+		// 29.97 drop frame skips frame numbers 0 and 1 every minute, except every tenth minute
+		const uint32_t DROP_FRAMES_PER_MINUTE		= 30 * 60 - 2;
+		const uint32_t DROP_FRAMES_PER_10_MINUTES	= DROP_FRAMES_PER_MINUTE * 10 + 2;
+	}
+
+	double Timecode::getFps() const{
+		switch( rate ){
+		case MTC_24_FPS:			return 24.0;
+		case MTC_25_FPS:			return 25.0;
+		case MTC_29_97_FPS_DROP:	return 30000.0 / 1001.0;
+		default:					return 30.0;
+		}
+	}
+
+	double Timecode::getSeconds( uint32_t now ) const{
+		if( !valid )
+			return 0.0;
+		double quarters = quarterFrames;
+		if( isRunning( now ) ){
+			const double elapsed = (int32_t) ( now - time ) * 1.0e-6 * getFps() * 4.0;
+			quarters += elapsed < 0.0 ? 0.0 : elapsed > 1.0 ? 1.0 : elapsed;
+		}
+		return quarters / ( 4.0 * getFps() );
+	}
+
+	uint32_t Timecode::toFrameNumber( int hours, int minutes, int seconds, int frames, TimecodeRate rate ){
+		static const int sNominal[] = { 24, 25, 30, 30 };
+		const uint32_t totalMinutes = hours * 60 + minutes;
+		uint32_t number = ( totalMinutes * 60 + seconds ) * sNominal[rate] + frames;
+		if( rate == MTC_29_97_FPS_DROP )
+			number -= 2 * ( totalMinutes - totalMinutes / 10 );
+		return number;
+	}
+
+	void Timecode::fromFrameNumber( uint32_t frameNumber, TimecodeRate rate, uint8_t *hours, uint8_t *minutes, uint8_t *seconds, uint8_t *frames ){
+		static const int sNominal[] = { 24, 25, 30, 30 };
+		if( rate == MTC_29_97_FPS_DROP ){
+			// put the dropped labels back, then count in plain 30 fps
+			const uint32_t tens = frameNumber / DROP_FRAMES_PER_10_MINUTES;
+			const uint32_t rest = frameNumber % DROP_FRAMES_PER_10_MINUTES;
+			frameNumber += 18 * tens + ( rest < 2 ? 0 : 2 * ( ( rest - 2 ) / DROP_FRAMES_PER_MINUTE ) );
+		}
+		const uint32_t fps = sNominal[rate];
+		*frames = uint8_t( frameNumber % fps );
+		*seconds = uint8_t( frameNumber / fps % 60 );
+		*minutes = uint8_t( frameNumber / ( fps * 60 ) % 60 );
+		*hours = uint8_t( frameNumber / ( fps * 3600 ) % 24 );
+	}
+
+	TimecodeTracker::TimecodeTracker(){
+		mSequence.store( 0 );
+		reset();
+	}
+
+	void TimecodeTracker::reset(){
+		for( uint8_t &piece : mPieces )
+			piece = 0;
+		mNextPiece = -1;
+		mValid = false;
+		mRunning = false;
+		mRate = MTC_30_FPS;
+		mQuarterFrames = 0;
+		mLastQuarterFrame = 0;
+		publish( 0 );
+	}
+
+	bool TimecodeTracker::process( const Event &event ){
+		if( event.status != MIDI_TIME_CODE )
+			return false;
+		onQuarterFrame( event.data1, event.time );
+		return true;
+	}
+
+	void TimecodeTracker::onQuarterFrame( uint8_t data, uint32_t time ){
+		const int piece = ( data >> 4 ) & 0x07;
+		mPieces[piece] = data & 0x0F;
+
+		// after a stop the pieces gathered before it belong to another position
+		if( mRunning && time - mLastQuarterFrame >= Timecode::TIMEOUT )
+			mNextPiece = -1;
+		mLastQuarterFrame = time;
+
+		// between complete sequences every quarter frame moves a quarter frame on
+		if( mValid )
+			++mQuarterFrames;
+		mRunning = true;
+
+		if( piece == 0 )
+			mNextPiece = 1;
+		else if( piece == mNextPiece )
+			++mNextPiece;
+		else
+			mNextPiece = -1;	// out of order or running backwards, wait for the next piece 0
+
+		if( mNextPiece == 8 ){
+			mRate = TimecodeRate( ( mPieces[7] >> 1 ) & 0x03 );
+			const uint32_t frame = Timecode::toFrameNumber(
+				( ( mPieces[7] & 0x01 ) << 4 ) | mPieces[6],
+				( ( mPieces[5] & 0x03 ) << 4 ) | mPieces[4],
+				( ( mPieces[3] & 0x03 ) << 4 ) | mPieces[2],
+				( ( mPieces[1] & 0x01 ) << 4 ) | mPieces[0],
+				mRate );
+			// the sequence describes the frame at piece 0, this is seven quarter frames later
+			mQuarterFrames = frame * 4 + 7;
+			mValid = true;
+			mNextPiece = -1;
+		}
+
+		publish( time );
+	}
+
+	bool TimecodeTracker::processSysex( const uint8_t *data, size_t size, uint32_t time ){
+		// F0 7F <device> 01 01 hr mn sc fr F7, the rate in bits 5 and 6 of hr
+		if( size < 10 || data[0] != MIDI_SYSEX || data[1] != 0x7F || data[3] != 0x01 || data[4] != 0x01 )
+			return false;
+
+		mRate = TimecodeRate( ( data[5] >> 5 ) & 0x03 );
+		mQuarterFrames = Timecode::toFrameNumber( data[5] & 0x1F, data[6] & 0x3F, data[7] & 0x3F, data[8] & 0x1F, mRate ) * 4;
+		mValid = true;
+		// a full frame message is a locate, playback resumes with quarter frames
+		mRunning = false;
+		mNextPiece = -1;
+		publish( time );
+		return true;
+	}
+
+	void TimecodeTracker::publish( uint32_t time ){
+		const uint8_t flags = uint8_t( mRate ) | ( mValid ? FLAG_VALID : 0 ) | ( mRunning ? FLAG_RUNNING : 0 );
+
+		// odd sequence numbers tell readers a write is in progress
+		mSequence.store( mSequence.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_release );
+		mStateQuarterFrames.store( mQuarterFrames, std::memory_order_relaxed );
+		mStateTime.store( time, std::memory_order_relaxed );
+		mStateFlags.store( flags, std::memory_order_relaxed );
+		mSequence.store( mSequence.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+	}
+
+	void TimecodeTracker::read( Timecode &timecode ) const{
+		uint32_t begin, end;
+		uint8_t flags;
+		do {
+			begin = mSequence.load( std::memory_order_acquire );
+			if( begin & 1 )
+				continue;
+			timecode.quarterFrames = mStateQuarterFrames.load( std::memory_order_relaxed );
+			timecode.time = mStateTime.load( std::memory_order_relaxed );
+			flags = mStateFlags.load( std::memory_order_relaxed );
+			std::atomic_thread_fence( std::memory_order_acquire );
+			end = mSequence.load( std::memory_order_relaxed );
+		} while( ( begin & 1 ) || begin != end );
+
+		timecode.rate = TimecodeRate( flags & 0x03 );
+		timecode.valid = ( flags & FLAG_VALID ) != 0;
+		timecode.running = ( flags & FLAG_RUNNING ) != 0;
+		Timecode::fromFrameNumber( timecode.quarterFrames / 4, timecode.rate, &timecode.hours, &timecode.minutes, &timecode.seconds, &timecode.frames );
+	}
+
+	void TimecodeTracker::read( Timecode &timecode, uint32_t now ) const{
+		read( timecode );
+		timecode.running = timecode.isRunning( now );
+	}
+
+}// namespace midi
+}// namespace cinder